@@ -2,6 +2,7 @@
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <climits>
 
 #include "../tests/tests-common.h"
 
@@ -9,6 +10,7 @@ template<typename T>
 class OutOfPlaceRunner {
 	std::vector<std::complex<T>> inVector, outVector;
 public:
+	using Sample = T;
 	size_t size;
 
 	OutOfPlaceRunner(size_t size) : size(size) {}
@@ -53,6 +55,7 @@ struct Benchmark {
 
 	template <typename Runner>
 	static void runBenchmark(Test &test, std::string name, std::string resultPrefix) {
+		using Sample = typename Runner::Sample;
 		auto sizes = getSizes();
 		std::sort(sizes.begin(), sizes.end());
 
@@ -61,11 +64,11 @@ struct Benchmark {
 			auto runner = Runner(size);
 
 			// The runner handles input/output allocation
-			std::complex<double> *input, *output;
+			std::complex<Sample> *input, *output;
 			runner.getPointers(&input, &output);
 
 			for (int i = 0; i < size; i++) {
-				input[i] = randomComplex<double>();
+				input[i] = randomComplex<Sample>();
 			}
 
 			timer.start();
@@ -103,4 +106,9 @@ struct Benchmark {
 		std::string resultPrefix = std::string("results/") + Implementation::resultTag();
 		runBenchmark<typename Implementation::DoubleOutOfPlace>(test, Implementation::name(), resultPrefix);
 	}
+
+	TEST_METHOD("float out-of-place", float_out) {
+		std::string resultPrefix = std::string("results/") + Implementation::resultTag() + "-float";
+		runBenchmark<typename Implementation::FloatOutOfPlace>(test, Implementation::name() + " (float)", resultPrefix);
+	}
 };
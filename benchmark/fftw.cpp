@@ -53,6 +53,31 @@ struct FFTW_Estimate {
 	};
 
 	using DoubleOutOfPlace = OutOfPlace<double>;
+
+	struct FloatOutOfPlace : public OutOfPlaceRunner<float> {
+		fftwf_plan fftForward;
+		fftwf_complex *input, *output;
+
+		FloatOutOfPlace(size_t size) : OutOfPlaceRunner<float>(size) {
+			input = (fftwf_complex*)fftwf_malloc(size*sizeof(fftwf_complex));
+			output = (fftwf_complex*)fftwf_malloc(size*sizeof(fftwf_complex));
+			fftForward = fftwf_plan_dft_1d(size, input, output, FFTW_FORWARD, searchLevel);
+		}
+		~FloatOutOfPlace() {
+			fftwf_destroy_plan(fftForward);
+			fftwf_free(input);
+			fftwf_free(output);
+		}
+
+		virtual void getPointers(std::complex<float> **inPointer, std::complex<float> **outPointer) {
+			*inPointer = (std::complex<float>*)input;
+			*outPointer = (std::complex<float>*)output;
+		}
+
+		void forward(std::complex<float> *input, std::complex<float> *output) {
+			fftwf_execute(fftForward);
+		}
+	};
 };
 static Benchmark<FFTW_Estimate<FFTW_ESTIMATE>> benchEstimate;
 static Benchmark<FFTW_Estimate<FFTW_MEASURE>, 65536> benchMeasure;
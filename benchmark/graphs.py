@@ -27,11 +27,20 @@ def plot_if_exists(axis, csvFile):
 
 figure, axis = article.wide()
 plot_if_exists(axis, "out/results/signalsmith.csv")
+plot_if_exists(axis, "out/results/signalsmith-measured.csv")
 plot_if_exists(axis, "out/results/fftw-estimate.csv")
 plot_if_exists(axis, "out/results/fftw-measure.csv")
 plot_if_exists(axis, "out/results/kissfft.csv")
 article.save("out/comparison", figure)
 
+figure, axis = article.wide()
+plot_if_exists(axis, "out/results/signalsmith-float.csv")
+plot_if_exists(axis, "out/results/signalsmith-measured-float.csv")
+plot_if_exists(axis, "out/results/fftw-estimate-float.csv")
+plot_if_exists(axis, "out/results/fftw-measure-float.csv")
+plot_if_exists(axis, "out/results/kissfft-float.csv")
+article.save("out/comparison-float", figure)
+
 figure, axis = article.wide()
 plot_if_exists(axis, "out/results/signalsmith.csv")
 plot_if_exists(axis, "out/results/previous-v4.csv")
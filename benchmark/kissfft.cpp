@@ -27,5 +27,6 @@ struct Kiss {
 	};
 
 	using DoubleOutOfPlace = OutOfPlace<double>;
+	using FloatOutOfPlace = OutOfPlace<float>;
 };
 Benchmark<Kiss> benchKiss;
@@ -2,21 +2,42 @@
 
 #include "benchmark.h"
 
+template<bool measured>
 struct Signalsmith {
 	static std::string name() {
-		return "Signalsmith";
+		return measured ? "Signalsmith (measured)" : "Signalsmith";
 	}
 	static std::string resultTag() {
-		return "signalsmith";
+		return measured ? "signalsmith-measured" : "signalsmith";
 	}
 	static std::string version() {
 		return "(development)";
 	}
 
+	// Kept between runs, so only new sizes are measured.  It's saved once, after all the benchmarks have run.
+	struct WisdomFile {
+		signalsmith::FFTWisdom wisdom;
+		WisdomFile() {
+			wisdom.load("results/signalsmith-wisdom.txt");
+		}
+		~WisdomFile() {
+			wisdom.save("results/signalsmith-wisdom.txt");
+		}
+	};
+	static signalsmith::FFTWisdom & wisdom() {
+		static WisdomFile file;
+		return file.wisdom;
+	}
+
 	template <typename T>
 	struct OutOfPlace : public OutOfPlaceRunner<T> {
 		signalsmith::FFT<T> fft;
-		OutOfPlace(size_t size) : OutOfPlaceRunner<T>(size), fft(size) {}
+		OutOfPlace(size_t size) : OutOfPlaceRunner<T>(size), fft(plan(size)) {}
+
+		static std::shared_ptr<const signalsmith::FFTPlan<T>> plan(size_t size) {
+			if (measured) return wisdom().template plan<T>(size);
+			return std::make_shared<signalsmith::FFTPlan<T>>(size);
+		}
 
 		void forward(std::complex<T> *input, std::complex<T> *output) {
 			fft.fft(input, output);
@@ -24,5 +45,7 @@ struct Signalsmith {
 	};
 
 	using DoubleOutOfPlace = OutOfPlace<double>;
+	using FloatOutOfPlace = OutOfPlace<float>;
 };
-Benchmark<Signalsmith> benchSignalsmith;
+Benchmark<Signalsmith<false>> benchSignalsmith;
+Benchmark<Signalsmith<true>> benchSignalsmithMeasured;
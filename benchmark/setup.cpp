@@ -0,0 +1,48 @@
+#include <string>
+#include <chrono>
+
+#include "benchmark.h"
+
+// Time taken to construct a transform (plan, twiddles and working memory), in milliseconds
+template<class Fn>
+double setupMs(Fn &&fn) {
+	double best = 1e10;
+	for (int repeat = 0; repeat < 5; ++repeat) {
+		auto start = std::chrono::high_resolution_clock::now();
+		fn();
+		std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+		best = std::min(best, duration.count()*1000);
+	}
+	return best;
+}
+
+TEST("Setup time", setup_time) {
+	std::vector<size_t> sizes;
+	for (size_t size = 64; size <= 4194304; size *= 4) {
+		sizes.push_back(size);
+		sizes.push_back(size*3/2);
+	}
+	// Rader and Bluestein
+	sizes.push_back(97*1024);
+	sizes.push_back(1009*1024);
+
+	std::ofstream outputCsv;
+	outputCsv.open("results/setup.csv");
+	outputCsv << "size,FFT<double>,FFT<float>,RealFFT<double>\n";
+	outputCsv.precision(15);
+
+	for (size_t size : sizes) {
+		double complexDouble = setupMs([&]() {
+			signalsmith::FFT<double> fft(size);
+		});
+		double complexFloat = setupMs([&]() {
+			signalsmith::FFT<float> fft(size);
+		});
+		double real = setupMs([&]() {
+			signalsmith::RealFFT<double> fft(size*2);
+		});
+		std::cout << "size " << size << ":\t" << complexDouble << "ms\t" << complexFloat << "ms (float)\t" << real << "ms (real)\n";
+		outputCsv << size << "," << complexDouble << "," << complexFloat << "," << real << "\n";
+	}
+	return test.pass();
+}
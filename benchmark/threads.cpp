@@ -0,0 +1,45 @@
+#include <string>
+#include <thread>
+
+#include "benchmark.h"
+
+// Scaling of large transforms with the number of threads
+TEST("Thread scaling", thread_scaling) {
+	size_t maxThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	std::vector<int> threadCounts;
+	for (size_t threads = 1; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	std::ofstream outputCsv;
+	outputCsv.open("results/threads.csv");
+	outputCsv << "size";
+	for (int threads : threadCounts) outputCsv << "," << threads << " threads";
+	outputCsv << "\n";
+	outputCsv.precision(15);
+
+	for (int size = 65536; size <= 16777216; size *= 4) {
+		std::vector<std::complex<double>> input(size), output(size);
+		for (auto &v : input) v = randomComplex<double>();
+		signalsmith::FFT<double> fft(size);
+
+		std::cout << "size " << size << ":\n";
+		std::vector<double> rates = BenchmarkRate::map<int>(threadCounts, [&](int threads, int repeats, Timer &timer) {
+			signalsmith::FFTThreadPool pool(threads);
+			fft.setExecutor(&pool);
+
+			timer.start();
+			for (int repeat = 0; repeat < repeats; ++repeat) {
+				fft.fft(input, output);
+			}
+			timer.stop();
+			fft.setExecutor(nullptr);
+		}, true);
+
+		outputCsv << size;
+		for (double rate : rates) outputCsv << "," << rate;
+		outputCsv << "\n";
+	}
+	return test.pass();
+}
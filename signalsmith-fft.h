@@ -10,6 +10,21 @@
 #include <cmath>
 #include <array>
 #include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <map>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <sstream>
 
 #ifndef SIGNALSMITH_INLINE
 #ifdef __GNUC__
@@ -21,10 +36,30 @@
 #endif
 #endif
 
+#ifndef SIGNALSMITH_RESTRICT
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define SIGNALSMITH_RESTRICT __restrict
+#else
+#define SIGNALSMITH_RESTRICT
+#endif
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338327950288
 #endif
 
+// Define SIGNALSMITH_FFT_NO_SIMD to use only the scalar butterflies
+#ifndef SIGNALSMITH_FFT_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIGNALSMITH_FFT_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef __AVX__
+#define SIGNALSMITH_FFT_AVX
+#include <immintrin.h>
+#endif
+#endif
+
 namespace SIGNALSMITH_FFT_NAMESPACE {
 
 	namespace perf {
@@ -50,461 +85,4145 @@ namespace SIGNALSMITH_FFT_NAMESPACE {
 				a.imag() + b.real()
 			};
 		}
-	}
-	
-	// Use SFINAE to get an iterator from std::begin(), if supported - otherwise assume the value itself is an iterator
-	template<typename T, typename=void>
-	struct GetIterator {
-		static T get(const T &t) {
-			return t;
-		}
-	};
-	template<typename T>
-	struct GetIterator<T, decltype((void)std::begin(std::declval<T>()))> {
-		static auto get(const T &t) -> decltype(std::begin(t)) {
-			return std::begin(t);
-		}
-	};
-
-	template<typename V>
-	class FFT {
-		using complex = std::complex<V>;
-		size_t _size;
-		std::vector<complex> workingVector;
-		
-		enum class StepType {
-			generic, step2, step3, step4
-		};
-		struct Step {
-			StepType type;
-			size_t factor;
-			size_t startIndex;
-			size_t innerRepeats;
-			size_t outerRepeats;
-			size_t twiddleIndex;
-		};
-		std::vector<size_t> factors;
-		std::vector<Step> plan;
-		std::vector<complex> twiddleVector;
-		
-		struct PermutationPair {size_t from, to;};
-		std::vector<PermutationPair> permutation;
-		
-		void addPlanSteps(size_t factorIndex, size_t start, size_t length, size_t repeats) {
-			if (factorIndex >= factors.size()) return;
-			
-			size_t factor = factors[factorIndex];
-			if (factorIndex + 1 < factors.size()) {
-				if (factors[factorIndex] == 2 && factors[factorIndex + 1] == 2) {
-					++factorIndex;
-					factor = 4;
-				}
-			}
-
-			size_t subLength = length/factor;
-			Step mainStep{StepType::generic, factor, start, subLength, repeats, twiddleVector.size()};
 
-			if (factor == 2) mainStep.type = StepType::step2;
-			if (factor == 3) mainStep.type = StepType::step3;
-			if (factor == 4) mainStep.type = StepType::step4;
+		// The roots of unity exp(-2*pi*i*k/period), for setting up twiddles.
+		// Symmetry reduces k to (at most) an eighth of the period, and larger ranges are split into coarse/fine tables, so cos()/sin() are only called O(sqrt(period)) times.
+		class UnitRoots {
+			size_t period, fineSize;
+			std::vector<std::complex<double>> fine, coarse;
 
-			// Twiddles
-			bool foundStep = false;
-			for (const Step &existingStep : plan) {
-				if (existingStep.factor == mainStep.factor && existingStep.innerRepeats == mainStep.innerRepeats) {
-					foundStep = true;
-					mainStep.twiddleIndex = existingStep.twiddleIndex;
-					break;
-				}
+			static std::complex<double> direct(size_t k, size_t period) {
+				double phase = 2*M_PI*k/period;
+				return {cos(phase), -sin(phase)};
 			}
-			if (!foundStep) {
-				for (size_t i = 0; i < subLength; ++i) {
-					for (size_t f = 0; f < factor; ++f) {
-						V phase = 2*M_PI*i*f/length;
-						complex twiddle = {cos(phase), -sin(phase)};
-						twiddleVector.push_back(twiddle);
-					}
-				}
-			}
-
-			if (repeats == 1 && sizeof(complex)*subLength > 65536) {
-				for (size_t i = 0; i < factor; ++i) {
-					addPlanSteps(factorIndex + 1, start + i*subLength, subLength, 1);
-				}
-			} else {
-				addPlanSteps(factorIndex + 1, start, subLength, repeats*factor);
+			// For 0 <= k <= period/8 (if divisible by 8), or < period/(4 or 2 or 1)
+			std::complex<double> reduced(size_t k) const {
+				if (coarse.empty()) return fine[k];
+				return complexMul<false>(coarse[k/fineSize], fine[k%fineSize]);
 			}
-			plan.push_back(mainStep);
-		}
-		void setPlan() {
-			factors.resize(0);
-			size_t size = _size, f = 2;
-			while (size > 1) {
-				if (size%f == 0) {
-					factors.push_back(f);
-					size /= f;
-				} else if (f > sqrt(size)) {
-					f = size;
-				} else {
-					++f;
+		public:
+			// A period of 0 is treated as 1, so empty transforms don't divide by zero
+			UnitRoots(size_t size) : period(std::max<size_t>(size, 1)) {
+				size_t tableSize = (period%8 == 0) ? period/8 + 1 : (period%4 == 0) ? period/4 : (period%2 == 0) ? period/2 : period;
+				fineSize = tableSize;
+				if (tableSize > 256) {
+					fineSize = (size_t)std::ceil(std::sqrt((double)tableSize));
+					for (size_t k = 0; k < tableSize; k += fineSize) coarse.push_back(direct(k, period));
 				}
+				fine.resize(fineSize);
+				for (size_t k = 0; k < fineSize; ++k) fine[k] = direct(k, period);
 			}
 
-			plan.resize(0);
-			twiddleVector.resize(0);
-			addPlanSteps(0, 0, _size, 1);
-			
-			permutation.resize(0);
-			permutation.push_back(PermutationPair{0, 0});
-			size_t indexLow = 0, indexHigh = factors.size();
-			size_t inputStepLow = _size, outputStepLow = 1;
-			size_t inputStepHigh = 1, outputStepHigh = _size;
-			while (outputStepLow*inputStepHigh < _size) {
-				size_t f, inputStep, outputStep;
-				if (outputStepLow <= inputStepHigh) {
-					f = factors[indexLow++];
-					inputStep = (inputStepLow /= f);
-					outputStep = outputStepLow;
-					outputStepLow *= f;
-				} else {
-					f = factors[--indexHigh];
-					inputStep = inputStepHigh;
-					inputStepHigh *= f;
-					outputStep = (outputStepHigh /= f);
+			std::complex<double> operator()(size_t k) const {
+				k %= period;
+				if (period%2 == 0 && k >= period/2) return -(*this)(k - period/2);
+				if (period%4 == 0 && k >= period/4) {
+					std::complex<double> r = (*this)(k - period/4);
+					return {r.imag(), -r.real()}; // multiplied by -i
 				}
-				size_t oldSize = permutation.size();
-				for (size_t i = 1; i < f; ++i) {
-					for (size_t j = 0; j < oldSize; ++j) {
-						PermutationPair pair = permutation[j];
-						pair.from += i*inputStep;
-						pair.to += i*outputStep;
-						permutation.push_back(pair);
-					}
+				if (period%8 == 0 && k > period/8) {
+					std::complex<double> r = reduced(period/4 - k);
+					return {-r.imag(), -r.real()};
 				}
+				return reduced(k);
 			}
-		}
+			template<typename V>
+			std::complex<V> get(size_t k) const {
+				std::complex<double> r = (*this)(k);
+				return {(V)r.real(), (V)r.imag()};
+			}
+		};
 
-		template<bool inverse, typename RandomAccessIterator>
-		void fftStepGeneric(RandomAccessIterator &&origData, const Step &step) {
-			complex *working = workingVector.data();
-			const size_t stride = step.innerRepeats;
+		// Butterfly kernels are written against an "access" type, which says how to load/store values, and how many butterflies it handles at once
+		template<typename V>
+		struct ScalarAccess {
+			using Value = std::complex<V>;
+			static constexpr size_t width = 1;
 
-			for (size_t outerRepeat = 0; outerRepeat < step.outerRepeats; ++outerRepeat) {
-				RandomAccessIterator data = origData;
-				
-				const complex *twiddles = twiddleVector.data() + step.twiddleIndex;
-				const size_t factor = step.factor;
-				for (size_t repeat = 0; repeat < step.innerRepeats; ++repeat) {
-					for (size_t i = 0; i < step.factor; ++i) {
-						working[i] = perf::complexMul<inverse>(data[i*stride], twiddles[i]);
-					}
-					for (size_t f = 0; f < factor; ++f) {
-						complex sum = working[0];
-						for (size_t i = 1; i < factor; ++i) {
-							V phase = 2*M_PI*f*i/factor;
-							complex factor = {cos(phase), -sin(phase)};
-							sum += perf::complexMul<inverse>(working[i], factor);
-						}
-						data[f*stride] = sum;
-					}
-					++data;
-					twiddles += factor;
-				}
-				origData += step.factor*step.innerRepeats;
+			template<typename RandomAccessIterator>
+			static SIGNALSMITH_INLINE Value load(RandomAccessIterator data, size_t index) {
+				return data[index];
 			}
-		}
-
-		template<bool inverse, typename RandomAccessIterator>
-		void fftStep2(RandomAccessIterator &&origData, const Step &step) {
-			const size_t stride = step.innerRepeats;
-			const complex *origTwiddles = twiddleVector.data() + step.twiddleIndex;
-			for (size_t outerRepeat = 0; outerRepeat < step.outerRepeats; ++outerRepeat) {
-				const complex* twiddles = origTwiddles;
-				for (RandomAccessIterator data = origData; data < origData + stride; ++data) {
-					complex A = data[0];
-					complex B = perf::complexMul<inverse>(data[stride], twiddles[1]);
-					
-					data[0] = A + B;
-					data[stride] = A - B;
-					twiddles += 2;
-				}
-				origData += 2*stride;
+			template<typename RandomAccessIterator>
+			static SIGNALSMITH_INLINE void store(RandomAccessIterator data, size_t index, const Value &value) {
+				data[index] = value;
 			}
-		}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<V> *twiddles, size_t index) {
+				return twiddles[index];
+			}
+		};
 
-		template<bool inverse, typename RandomAccessIterator>
-		void fftStep3(RandomAccessIterator &&origData, const Step &step) {
-			constexpr complex factor3 = {-0.5, inverse ? 0.8660254037844386 : -0.8660254037844386};
-			const size_t stride = step.innerRepeats;
-			const complex *origTwiddles = twiddleVector.data() + step.twiddleIndex;
-			
-			for (size_t outerRepeat = 0; outerRepeat < step.outerRepeats; ++outerRepeat) {
-				const complex* twiddles = origTwiddles;
-				for (RandomAccessIterator data = origData; data < origData + stride; ++data) {
-					complex A = data[0];
-					complex B = perf::complexMul<inverse>(data[stride], twiddles[1]);
-					complex C = perf::complexMul<inverse>(data[stride*2], twiddles[2]);
-					
-					complex realSum = A + (B + C)*factor3.real();
-					complex imagSum = (B - C)*factor3.imag();
+		// One butterfly in each of several consecutive repeats of a step, for SIMD access across repeats
+		template<typename V>
+		struct RepeatPointer {
+			std::complex<V> *pointer;
+			size_t repeatStride;
+		};
 
-					data[0] = A + B + C;
-					data[stride] = perf::complexAddI<false>(realSum, imagSum);
-					data[stride*2] = perf::complexAddI<true>(realSum, imagSum);
+#ifdef SIGNALSMITH_FFT_SSE2
+		// A single std::complex<double>, as (real, imag)
+		struct ComplexSse2 {
+			__m128d v;
 
-					twiddles += 3;
-				}
-				origData += 3*stride;
+			SIGNALSMITH_INLINE ComplexSse2 operator+(const ComplexSse2 &other) const {
+				return {_mm_add_pd(v, other.v)};
+			}
+			SIGNALSMITH_INLINE ComplexSse2 operator-(const ComplexSse2 &other) const {
+				return {_mm_sub_pd(v, other.v)};
 			}
+			SIGNALSMITH_INLINE ComplexSse2 operator*(double scale) const {
+				return {_mm_mul_pd(v, _mm_set1_pd(scale))};
+			}
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE ComplexSse2 complexMul(const ComplexSse2 &a, const ComplexSse2 &b) {
+			__m128d bReal = _mm_unpacklo_pd(b.v, b.v), bImag = _mm_unpackhi_pd(b.v, b.v);
+			__m128d aSwap = _mm_shuffle_pd(a.v, a.v, 1);
+			__m128d sign = conjugateSecond ? _mm_set_pd(-0.0, 0.0) : _mm_set_pd(0.0, -0.0);
+			return {_mm_add_pd(_mm_mul_pd(a.v, bReal), _mm_xor_pd(_mm_mul_pd(aSwap, bImag), sign))};
+		}
+		template<bool flipped>
+		SIGNALSMITH_INLINE ComplexSse2 complexAddI(const ComplexSse2 &a, const ComplexSse2 &b) {
+			__m128d bSwap = _mm_shuffle_pd(b.v, b.v, 1);
+			__m128d sign = flipped ? _mm_set_pd(-0.0, 0.0) : _mm_set_pd(0.0, -0.0);
+			return {_mm_add_pd(a.v, _mm_xor_pd(bSwap, sign))};
 		}
 
-		template<bool inverse, typename RandomAccessIterator>
-		void fftStep4(RandomAccessIterator &&origData, const Step &step) {
-			const size_t stride = step.innerRepeats;
-			const complex *origTwiddles = twiddleVector.data() + step.twiddleIndex;
-			
-			for (size_t outerRepeat = 0; outerRepeat < step.outerRepeats; ++outerRepeat) {
-				const complex* twiddles = origTwiddles;
-				for (RandomAccessIterator data = origData; data < origData + stride; ++data) {
-					complex A = data[0];
-					complex C = perf::complexMul<inverse>(data[stride], twiddles[2]);
-					complex B = perf::complexMul<inverse>(data[stride*2], twiddles[1]);
-					complex D = perf::complexMul<inverse>(data[stride*3], twiddles[3]);
-
-					complex sumAC = A + C, sumBD = B + D;
-					complex diffAC = A - C, diffBD = B - D;
-
-					data[0] = sumAC + sumBD;
-					data[stride] = perf::complexAddI<!inverse>(diffAC, diffBD);
-					data[stride*2] = sumAC - sumBD;
-					data[stride*3] = perf::complexAddI<inverse>(diffAC, diffBD);
+		struct Sse2Access {
+			using Value = ComplexSse2;
+			static constexpr size_t width = 1;
 
-					twiddles += 4;
-				}
-				origData += 4*stride;
+			static SIGNALSMITH_INLINE Value load(const std::complex<double> *data, size_t index) {
+				return {_mm_loadu_pd(reinterpret_cast<const double *>(data + index))};
 			}
-		}
-		
-		template<typename InputIterator, typename OutputIterator>
-		void permute(InputIterator input, OutputIterator data) {
-			for (auto pair : permutation) {
-				data[pair.from] = input[pair.to];
+			static SIGNALSMITH_INLINE void store(std::complex<double> *data, size_t index, const Value &value) {
+				_mm_storeu_pd(reinterpret_cast<double *>(data + index), value.v);
 			}
-		}
-
-		template<bool inverse, typename InputIterator, typename OutputIterator>
-		void run(InputIterator &&input, OutputIterator &&data) {
-			permute(input, data);
-			
-			for (const Step &step : plan) {
-				switch (step.type) {
-					case StepType::generic:
-						fftStepGeneric<inverse>(data + step.startIndex, step);
-						break;
-					case StepType::step2:
-						fftStep2<inverse>(data + step.startIndex, step);
-						break;
-					case StepType::step3:
-						fftStep3<inverse>(data + step.startIndex, step);
-						break;
-					case StepType::step4:
-						fftStep4<inverse>(data + step.startIndex, step);
-						break;
-				}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<double> *twiddles, size_t index) {
+				return load(twiddles, index);
 			}
-		}
+		};
 
-		static bool validSize(size_t size) {
-			constexpr static bool filter[32] = {
-				1, 1, 1, 1, 1, 0, 1, 0, 1, 1, // 0-9
-				0, 0, 1, 0, 0, 0, 1, 0, 1, 0, // 10-19
-				0, 0, 0, 0, 1, 0, 0, 0, 0, 0, // 20-29
-				0, 0
-			};
-			return filter[size];
-		}
-	public:
-		static size_t sizeMinimum(size_t size) {
-			size_t power2 = 1;
-			while (size >= 32) {
-				size = (size - 1)/2 + 1;
-				power2 *= 2;
-			}
-			while (size < 32 && !validSize(size)) {
-				++size;
+		// Two std::complex<float>s, as (real, imag, real, imag)
+		struct ComplexSse2Float {
+			__m128 v;
+
+			SIGNALSMITH_INLINE ComplexSse2Float operator+(const ComplexSse2Float &other) const {
+				return {_mm_add_ps(v, other.v)};
 			}
-			return power2*size;
-		}
-		static size_t sizeMaximum(size_t size) {
-			size_t power2 = 1;
-			while (size >= 32) {
-				size /= 2;
-				power2 *= 2;
+			SIGNALSMITH_INLINE ComplexSse2Float operator-(const ComplexSse2Float &other) const {
+				return {_mm_sub_ps(v, other.v)};
 			}
-			while (size > 1 && !validSize(size)) {
-				--size;
+			SIGNALSMITH_INLINE ComplexSse2Float operator*(float scale) const {
+				return {_mm_mul_ps(v, _mm_set1_ps(scale))};
 			}
-			return power2*size;
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE ComplexSse2Float complexMul(const ComplexSse2Float &a, const ComplexSse2Float &b) {
+			__m128 bReal = _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(2, 2, 0, 0)), bImag = _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(3, 3, 1, 1));
+			__m128 aSwap = _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1));
+			__m128 sign = conjugateSecond ? _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f) : _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+			return {_mm_add_ps(_mm_mul_ps(a.v, bReal), _mm_xor_ps(_mm_mul_ps(aSwap, bImag), sign))};
 		}
-
-		FFT(size_t size, int fastDirection=0) : _size(0) {
-			if (fastDirection > 0) size = sizeMinimum(size);
-			if (fastDirection < 0) size = sizeMaximum(size);
-			this->setSize(size);
+		template<bool flipped>
+		SIGNALSMITH_INLINE ComplexSse2Float complexAddI(const ComplexSse2Float &a, const ComplexSse2Float &b) {
+			__m128 bSwap = _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(2, 3, 0, 1));
+			__m128 sign = flipped ? _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f) : _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+			return {_mm_add_ps(a.v, _mm_xor_ps(bSwap, sign))};
 		}
 
-		size_t setSize(size_t size) {
-			if (size != _size) {
-				_size = size;
-				workingVector.resize(size);
-				setPlan();
+		struct Sse2FloatAccess {
+			using Value = ComplexSse2Float;
+			static constexpr size_t width = 2;
+
+			static SIGNALSMITH_INLINE Value load(const std::complex<float> *data, size_t index) {
+				return {_mm_loadu_ps(reinterpret_cast<const float *>(data + index))};
 			}
-			return _size;
-		}
-		size_t setSizeMinimum(size_t size) {
-			return setSize(sizeMinimum(size));
-		}
-		size_t setSizeMaximum(size_t size) {
-			return setSize(sizeMaximum(size));
-		}
-		const size_t & size() const {
-			return _size;
-		}
+			static SIGNALSMITH_INLINE void store(std::complex<float> *data, size_t index, const Value &value) {
+				_mm_storeu_ps(reinterpret_cast<float *>(data + index), value.v);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<float> *twiddles, size_t index) {
+				return load(twiddles, index);
+			}
+		};
 
-		template<typename InputIterator, typename OutputIterator>
-		void fft(InputIterator &&input, OutputIterator &&output) {
-			auto inputIter = GetIterator<InputIterator>::get(input);
-			auto outputIter = GetIterator<OutputIterator>::get(output);
-			return run<false>(inputIter, outputIter);
+		// Two std::complex<float>s from anywhere, as one 128-bit value
+		SIGNALSMITH_INLINE __m128 loadPair(const std::complex<float> *a, const std::complex<float> *b) {
+			return _mm_castpd_ps(_mm_loadh_pd(_mm_load_sd(reinterpret_cast<const double *>(a)), reinterpret_cast<const double *>(b)));
 		}
-
-		template<typename InputIterator, typename OutputIterator>
-		void ifft(InputIterator &&input, OutputIterator &&output) {
-			auto inputIter = GetIterator<InputIterator>::get(input);
-			auto outputIter = GetIterator<OutputIterator>::get(output);
-			return run<true>(inputIter, outputIter);
+		SIGNALSMITH_INLINE void storePair(std::complex<float> *a, std::complex<float> *b, __m128 v) {
+			_mm_store_sd(reinterpret_cast<double *>(a), _mm_castps_pd(v));
+			_mm_storeh_pd(reinterpret_cast<double *>(b), _mm_castps_pd(v));
 		}
-	};
 
-	struct FFTOptions {
-		static constexpr int halfFreqShift = 1;
-	};
+		// The same butterfly from two consecutive repeats (see `ButterflyRepeats`)
+		struct Sse2FloatRepeatAccess {
+			using Value = ComplexSse2Float;
+			static constexpr size_t width = 1, repeats = 2;
 
-	template<typename V, int optionFlags=0>
-	class RealFFT {
-		static constexpr bool modified = (optionFlags&FFTOptions::halfFreqShift);
+			static SIGNALSMITH_INLINE Value load(const RepeatPointer<float> &data, size_t index) {
+				const std::complex<float> *pointer = data.pointer + index;
+				return {loadPair(pointer, pointer + data.repeatStride)};
+			}
+			static SIGNALSMITH_INLINE void store(const RepeatPointer<float> &data, size_t index, const Value &value) {
+				std::complex<float> *pointer = data.pointer + index;
+				storePair(pointer, pointer + data.repeatStride, value.v);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<float> *twiddles, size_t index) {
+				return {_mm_castpd_ps(_mm_load1_pd(reinterpret_cast<const double *>(twiddles + index)))};
+			}
+		};
+#endif
+#ifdef SIGNALSMITH_FFT_AVX
+		// Two std::complex<double>s, as (real, imag, real, imag)
+		struct ComplexAvx {
+			__m256d v;
 
-		using complex = std::complex<V>;
-		std::vector<complex> complexBuffer1, complexBuffer2;
-		std::vector<complex> twiddlesMinusI;
-		std::vector<complex> modifiedRotations;
-		FFT<V> complexFft;
-	public:
-		static size_t sizeMinimum(size_t size) {
-			return (FFT<V>::sizeMinimum((size - 1)/2) + 1)*2;
+			SIGNALSMITH_INLINE ComplexAvx operator+(const ComplexAvx &other) const {
+				return {_mm256_add_pd(v, other.v)};
+			}
+			SIGNALSMITH_INLINE ComplexAvx operator-(const ComplexAvx &other) const {
+				return {_mm256_sub_pd(v, other.v)};
+			}
+			SIGNALSMITH_INLINE ComplexAvx operator*(double scale) const {
+				return {_mm256_mul_pd(v, _mm256_set1_pd(scale))};
+			}
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE ComplexAvx complexMul(const ComplexAvx &a, const ComplexAvx &b) {
+			__m256d bReal = _mm256_movedup_pd(b.v), bImag = _mm256_permute_pd(b.v, 15);
+			__m256d cross = _mm256_mul_pd(_mm256_permute_pd(a.v, 5), bImag);
+#ifdef __FMA__
+			return {conjugateSecond ? _mm256_fmsubadd_pd(a.v, bReal, cross) : _mm256_fmaddsub_pd(a.v, bReal, cross)};
+#else
+			if (conjugateSecond) cross = _mm256_xor_pd(cross, _mm256_set1_pd(-0.0));
+			return {_mm256_addsub_pd(_mm256_mul_pd(a.v, bReal), cross)};
+#endif
 		}
-		static size_t sizeMaximum(size_t size) {
-			return FFT<V>::sizeMinimum(size/2)*2;
+		template<bool flipped>
+		SIGNALSMITH_INLINE ComplexAvx complexAddI(const ComplexAvx &a, const ComplexAvx &b) {
+			__m256d bSwap = _mm256_permute_pd(b.v, 5);
+			if (flipped) bSwap = _mm256_xor_pd(bSwap, _mm256_set1_pd(-0.0));
+			return {_mm256_addsub_pd(a.v, bSwap)};
 		}
 
-		RealFFT(size_t size, int fastDirection=0) : complexFft(0) {
-			if (fastDirection > 0) size = sizeMinimum(size);
-			if (fastDirection < 0) size = sizeMaximum(size);
-			this->setSize(size);
-		}
+		struct AvxAccess {
+			using Value = ComplexAvx;
+			static constexpr size_t width = 2;
 
-		size_t setSize(size_t size) {
-			complexBuffer1.resize(size/2);
-			complexBuffer2.resize(size/2);
+			static SIGNALSMITH_INLINE Value load(const std::complex<double> *data, size_t index) {
+				return {_mm256_loadu_pd(reinterpret_cast<const double *>(data + index))};
+			}
+			static SIGNALSMITH_INLINE void store(std::complex<double> *data, size_t index, const Value &value) {
+				_mm256_storeu_pd(reinterpret_cast<double *>(data + index), value.v);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<double> *twiddles, size_t index) {
+				return load(twiddles, index);
+			}
+		};
+
+		// Four std::complex<float>s, as (real, imag, real, imag, ...)
+		struct ComplexAvxFloat {
+			__m256 v;
 
-			size_t hhSize = size/4 + 1;
-			twiddlesMinusI.resize(hhSize);
-			for (size_t i = 0; i < hhSize; ++i) {
-				double rotPhase = -2*M_PI*(modified ? i + 0.5 : i)/size;
-				twiddlesMinusI[i] = {sin(rotPhase), -cos(rotPhase)};
+			SIGNALSMITH_INLINE ComplexAvxFloat operator+(const ComplexAvxFloat &other) const {
+				return {_mm256_add_ps(v, other.v)};
 			}
-			if (modified) {
-				modifiedRotations.resize(size/2);
-				for (size_t i = 0; i < size/2; ++i) {
-					double rotPhase = -2*M_PI*i/size;
-					modifiedRotations[i] = {cos(rotPhase), sin(rotPhase)};
-				}
+			SIGNALSMITH_INLINE ComplexAvxFloat operator-(const ComplexAvxFloat &other) const {
+				return {_mm256_sub_ps(v, other.v)};
 			}
-			
-			return complexFft.setSize(size/2);
-		}
-		size_t setSizeMinimum(size_t size) {
-			return setSize(sizeMinimum(size));
-		}
-		size_t setSizeMaximum(size_t size) {
-			return setSize(sizeMaximum(size));
+			SIGNALSMITH_INLINE ComplexAvxFloat operator*(float scale) const {
+				return {_mm256_mul_ps(v, _mm256_set1_ps(scale))};
+			}
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE ComplexAvxFloat complexMul(const ComplexAvxFloat &a, const ComplexAvxFloat &b) {
+			__m256 bReal = _mm256_moveldup_ps(b.v), bImag = _mm256_movehdup_ps(b.v);
+			__m256 cross = _mm256_mul_ps(_mm256_permute_ps(a.v, _MM_SHUFFLE(2, 3, 0, 1)), bImag);
+#ifdef __FMA__
+			return {conjugateSecond ? _mm256_fmsubadd_ps(a.v, bReal, cross) : _mm256_fmaddsub_ps(a.v, bReal, cross)};
+#else
+			if (conjugateSecond) cross = _mm256_xor_ps(cross, _mm256_set1_ps(-0.0f));
+			return {_mm256_addsub_ps(_mm256_mul_ps(a.v, bReal), cross)};
+#endif
 		}
-		size_t size() const {
-			return complexFft.size()*2;
+		template<bool flipped>
+		SIGNALSMITH_INLINE ComplexAvxFloat complexAddI(const ComplexAvxFloat &a, const ComplexAvxFloat &b) {
+			__m256 bSwap = _mm256_permute_ps(b.v, _MM_SHUFFLE(2, 3, 0, 1));
+			if (flipped) bSwap = _mm256_xor_ps(bSwap, _mm256_set1_ps(-0.0f));
+			return {_mm256_addsub_ps(a.v, bSwap)};
 		}
 
-		template<typename InputIterator, typename OutputIterator>
-		void fft(InputIterator &&input, OutputIterator &&output) {
+		struct AvxFloatAccess {
+			using Value = ComplexAvxFloat;
+			static constexpr size_t width = 4;
+
+			static SIGNALSMITH_INLINE Value load(const std::complex<float> *data, size_t index) {
+				return {_mm256_loadu_ps(reinterpret_cast<const float *>(data + index))};
+			}
+			static SIGNALSMITH_INLINE void store(std::complex<float> *data, size_t index, const Value &value) {
+				_mm256_storeu_ps(reinterpret_cast<float *>(data + index), value.v);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<float> *twiddles, size_t index) {
+				return load(twiddles, index);
+			}
+		};
+
+		// The same butterfly from four consecutive repeats (see `ButterflyRepeats`)
+		struct AvxFloatRepeatAccess {
+			using Value = ComplexAvxFloat;
+			static constexpr size_t width = 1, repeats = 4;
+
+			static SIGNALSMITH_INLINE Value load(const RepeatPointer<float> &data, size_t index) {
+				const std::complex<float> *pointer = data.pointer + index;
+				const size_t repeatStride = data.repeatStride;
+				__m128 low = loadPair(pointer, pointer + repeatStride), high = loadPair(pointer + repeatStride*2, pointer + repeatStride*3);
+				return {_mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1)};
+			}
+			static SIGNALSMITH_INLINE void store(const RepeatPointer<float> &data, size_t index, const Value &value) {
+				std::complex<float> *pointer = data.pointer + index;
+				const size_t repeatStride = data.repeatStride;
+				storePair(pointer, pointer + repeatStride, _mm256_castps256_ps128(value.v));
+				storePair(pointer + repeatStride*2, pointer + repeatStride*3, _mm256_extractf128_ps(value.v, 1));
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<float> *twiddles, size_t index) {
+				return {_mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double *>(twiddles + index)))};
+			}
+		};
+#endif
+
+		// Batches of channels are interleaved, with each channel in a separate SIMD lane.  For each index, the real parts for all lanes come first, then the imaginary parts.
+		template<typename V>
+		struct BatchAccess {
+			static constexpr size_t lanes = 1;
+		};
+#ifdef SIGNALSMITH_FFT_AVX
+		// Four channels of std::complex<double>, as (real, real, real, real), (imag, imag, imag, imag)
+		struct SplitAvx {
+			__m256d real, imag;
+
+			SIGNALSMITH_INLINE SplitAvx operator+(const SplitAvx &other) const {
+				return {_mm256_add_pd(real, other.real), _mm256_add_pd(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitAvx operator-(const SplitAvx &other) const {
+				return {_mm256_sub_pd(real, other.real), _mm256_sub_pd(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitAvx operator*(double scale) const {
+				__m256d s = _mm256_set1_pd(scale);
+				return {_mm256_mul_pd(real, s), _mm256_mul_pd(imag, s)};
+			}
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE SplitAvx complexMul(const SplitAvx &a, const SplitAvx &b) {
+			__m256d rr = _mm256_mul_pd(a.real, b.real), ii = _mm256_mul_pd(a.imag, b.imag);
+			__m256d ir = _mm256_mul_pd(a.imag, b.real), ri = _mm256_mul_pd(a.real, b.imag);
+			return conjugateSecond ? SplitAvx{_mm256_add_pd(rr, ii), _mm256_sub_pd(ir, ri)} : SplitAvx{_mm256_sub_pd(rr, ii), _mm256_add_pd(ir, ri)};
+		}
+		template<bool flipped>
+		SIGNALSMITH_INLINE SplitAvx complexAddI(const SplitAvx &a, const SplitAvx &b) {
+			return flipped ? SplitAvx{_mm256_add_pd(a.real, b.imag), _mm256_sub_pd(a.imag, b.real)} : SplitAvx{_mm256_sub_pd(a.real, b.imag), _mm256_add_pd(a.imag, b.real)};
+		}
+
+		template<>
+		struct BatchAccess<double> {
+			static constexpr size_t lanes = 4;
+			using Value = SplitAvx;
+			static constexpr size_t width = 1;
+
+			static SIGNALSMITH_INLINE Value load(const std::complex<double> *data, size_t index) {
+				const double *values = reinterpret_cast<const double *>(data + index*lanes);
+				return {_mm256_loadu_pd(values), _mm256_loadu_pd(values + lanes)};
+			}
+			static SIGNALSMITH_INLINE void store(std::complex<double> *data, size_t index, const Value &value) {
+				double *values = reinterpret_cast<double *>(data + index*lanes);
+				_mm256_storeu_pd(values, value.real);
+				_mm256_storeu_pd(values + lanes, value.imag);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<double> *twiddles, size_t index) {
+				const double *values = reinterpret_cast<const double *>(twiddles + index);
+				return {_mm256_broadcast_sd(values), _mm256_broadcast_sd(values + 1)};
+			}
+
+			// Converts between one value from each channel and the split format.  The lanes are in the order (0, 2, 1, 3), which saves a shuffle.
+			static SIGNALSMITH_INLINE Value gather(const std::complex<double> * const *channels, size_t index) {
+				__m256d a = _mm256_insertf128_pd(_mm256_castpd128_pd256(loadComplex(channels[0] + index)), loadComplex(channels[1] + index), 1);
+				__m256d b = _mm256_insertf128_pd(_mm256_castpd128_pd256(loadComplex(channels[2] + index)), loadComplex(channels[3] + index), 1);
+				return {_mm256_unpacklo_pd(a, b), _mm256_unpackhi_pd(a, b)};
+			}
+			static SIGNALSMITH_INLINE void scatter(const Value &value, std::complex<double> * const *channels, size_t index) {
+				__m256d a = _mm256_unpacklo_pd(value.real, value.imag), b = _mm256_unpackhi_pd(value.real, value.imag);
+				storeComplex(channels[0] + index, _mm256_castpd256_pd128(a));
+				storeComplex(channels[1] + index, _mm256_extractf128_pd(a, 1));
+				storeComplex(channels[2] + index, _mm256_castpd256_pd128(b));
+				storeComplex(channels[3] + index, _mm256_extractf128_pd(b, 1));
+			}
+		private:
+			static SIGNALSMITH_INLINE __m128d loadComplex(const std::complex<double> *value) {
+				return _mm_loadu_pd(reinterpret_cast<const double *>(value));
+			}
+			static SIGNALSMITH_INLINE void storeComplex(std::complex<double> *value, __m128d v) {
+				_mm_storeu_pd(reinterpret_cast<double *>(value), v);
+			}
+		};
+
+		// Eight channels of std::complex<float>, as (real x8), (imag x8)
+		struct SplitAvxFloat {
+			__m256 real, imag;
+
+			SIGNALSMITH_INLINE SplitAvxFloat operator+(const SplitAvxFloat &other) const {
+				return {_mm256_add_ps(real, other.real), _mm256_add_ps(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitAvxFloat operator-(const SplitAvxFloat &other) const {
+				return {_mm256_sub_ps(real, other.real), _mm256_sub_ps(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitAvxFloat operator*(float scale) const {
+				__m256 s = _mm256_set1_ps(scale);
+				return {_mm256_mul_ps(real, s), _mm256_mul_ps(imag, s)};
+			}
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE SplitAvxFloat complexMul(const SplitAvxFloat &a, const SplitAvxFloat &b) {
+			__m256 rr = _mm256_mul_ps(a.real, b.real), ii = _mm256_mul_ps(a.imag, b.imag);
+			__m256 ir = _mm256_mul_ps(a.imag, b.real), ri = _mm256_mul_ps(a.real, b.imag);
+			return conjugateSecond ? SplitAvxFloat{_mm256_add_ps(rr, ii), _mm256_sub_ps(ir, ri)} : SplitAvxFloat{_mm256_sub_ps(rr, ii), _mm256_add_ps(ir, ri)};
+		}
+		template<bool flipped>
+		SIGNALSMITH_INLINE SplitAvxFloat complexAddI(const SplitAvxFloat &a, const SplitAvxFloat &b) {
+			return flipped ? SplitAvxFloat{_mm256_add_ps(a.real, b.imag), _mm256_sub_ps(a.imag, b.real)} : SplitAvxFloat{_mm256_sub_ps(a.real, b.imag), _mm256_add_ps(a.imag, b.real)};
+		}
+
+		template<>
+		struct BatchAccess<float> {
+			static constexpr size_t lanes = 8;
+			using Value = SplitAvxFloat;
+			static constexpr size_t width = 1;
+
+			static SIGNALSMITH_INLINE Value load(const std::complex<float> *data, size_t index) {
+				const float *values = reinterpret_cast<const float *>(data + index*lanes);
+				return {_mm256_loadu_ps(values), _mm256_loadu_ps(values + lanes)};
+			}
+			static SIGNALSMITH_INLINE void store(std::complex<float> *data, size_t index, const Value &value) {
+				float *values = reinterpret_cast<float *>(data + index*lanes);
+				_mm256_storeu_ps(values, value.real);
+				_mm256_storeu_ps(values + lanes, value.imag);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<float> *twiddles, size_t index) {
+				const float *values = reinterpret_cast<const float *>(twiddles + index);
+				return {_mm256_broadcast_ss(values), _mm256_broadcast_ss(values + 1)};
+			}
+
+			// Converts between one value from each channel and the split format
+			static SIGNALSMITH_INLINE Value gather(const std::complex<float> * const *channels, size_t index) {
+				__m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(loadPair(channels[0] + index, channels[1] + index)), loadPair(channels[4] + index, channels[5] + index), 1);
+				__m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(loadPair(channels[2] + index, channels[3] + index)), loadPair(channels[6] + index, channels[7] + index), 1);
+				return {_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))};
+			}
+			static SIGNALSMITH_INLINE void scatter(const Value &value, std::complex<float> * const *channels, size_t index) {
+				__m256 a = _mm256_unpacklo_ps(value.real, value.imag), b = _mm256_unpackhi_ps(value.real, value.imag);
+				storePair(channels[0] + index, channels[1] + index, _mm256_castps256_ps128(a));
+				storePair(channels[2] + index, channels[3] + index, _mm256_castps256_ps128(b));
+				storePair(channels[4] + index, channels[5] + index, _mm256_extractf128_ps(a, 1));
+				storePair(channels[6] + index, channels[7] + index, _mm256_extractf128_ps(b, 1));
+			}
+		};
+#elif defined(SIGNALSMITH_FFT_SSE2)
+		// Two channels of std::complex<double>, as (real, real), (imag, imag)
+		struct SplitSse2 {
+			__m128d real, imag;
+
+			SIGNALSMITH_INLINE SplitSse2 operator+(const SplitSse2 &other) const {
+				return {_mm_add_pd(real, other.real), _mm_add_pd(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitSse2 operator-(const SplitSse2 &other) const {
+				return {_mm_sub_pd(real, other.real), _mm_sub_pd(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitSse2 operator*(double scale) const {
+				__m128d s = _mm_set1_pd(scale);
+				return {_mm_mul_pd(real, s), _mm_mul_pd(imag, s)};
+			}
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE SplitSse2 complexMul(const SplitSse2 &a, const SplitSse2 &b) {
+			__m128d rr = _mm_mul_pd(a.real, b.real), ii = _mm_mul_pd(a.imag, b.imag);
+			__m128d ir = _mm_mul_pd(a.imag, b.real), ri = _mm_mul_pd(a.real, b.imag);
+			return conjugateSecond ? SplitSse2{_mm_add_pd(rr, ii), _mm_sub_pd(ir, ri)} : SplitSse2{_mm_sub_pd(rr, ii), _mm_add_pd(ir, ri)};
+		}
+		template<bool flipped>
+		SIGNALSMITH_INLINE SplitSse2 complexAddI(const SplitSse2 &a, const SplitSse2 &b) {
+			return flipped ? SplitSse2{_mm_add_pd(a.real, b.imag), _mm_sub_pd(a.imag, b.real)} : SplitSse2{_mm_sub_pd(a.real, b.imag), _mm_add_pd(a.imag, b.real)};
+		}
+
+		template<>
+		struct BatchAccess<double> {
+			static constexpr size_t lanes = 2;
+			using Value = SplitSse2;
+			static constexpr size_t width = 1;
+
+			static SIGNALSMITH_INLINE Value load(const std::complex<double> *data, size_t index) {
+				const double *values = reinterpret_cast<const double *>(data + index*lanes);
+				return {_mm_loadu_pd(values), _mm_loadu_pd(values + lanes)};
+			}
+			static SIGNALSMITH_INLINE void store(std::complex<double> *data, size_t index, const Value &value) {
+				double *values = reinterpret_cast<double *>(data + index*lanes);
+				_mm_storeu_pd(values, value.real);
+				_mm_storeu_pd(values + lanes, value.imag);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<double> *twiddles, size_t index) {
+				const double *values = reinterpret_cast<const double *>(twiddles + index);
+				return {_mm_set1_pd(values[0]), _mm_set1_pd(values[1])};
+			}
+
+			// Converts between one value from each channel and the split format
+			static SIGNALSMITH_INLINE Value gather(const std::complex<double> * const *channels, size_t index) {
+				__m128d a = _mm_loadu_pd(reinterpret_cast<const double *>(channels[0] + index));
+				__m128d b = _mm_loadu_pd(reinterpret_cast<const double *>(channels[1] + index));
+				return {_mm_unpacklo_pd(a, b), _mm_unpackhi_pd(a, b)};
+			}
+			static SIGNALSMITH_INLINE void scatter(const Value &value, std::complex<double> * const *channels, size_t index) {
+				_mm_storeu_pd(reinterpret_cast<double *>(channels[0] + index), _mm_unpacklo_pd(value.real, value.imag));
+				_mm_storeu_pd(reinterpret_cast<double *>(channels[1] + index), _mm_unpackhi_pd(value.real, value.imag));
+			}
+		};
+
+		// Four channels of std::complex<float>, as (real x4), (imag x4)
+		struct SplitSse2Float {
+			__m128 real, imag;
+
+			SIGNALSMITH_INLINE SplitSse2Float operator+(const SplitSse2Float &other) const {
+				return {_mm_add_ps(real, other.real), _mm_add_ps(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitSse2Float operator-(const SplitSse2Float &other) const {
+				return {_mm_sub_ps(real, other.real), _mm_sub_ps(imag, other.imag)};
+			}
+			SIGNALSMITH_INLINE SplitSse2Float operator*(float scale) const {
+				__m128 s = _mm_set1_ps(scale);
+				return {_mm_mul_ps(real, s), _mm_mul_ps(imag, s)};
+			}
+		};
+		template <bool conjugateSecond>
+		SIGNALSMITH_INLINE SplitSse2Float complexMul(const SplitSse2Float &a, const SplitSse2Float &b) {
+			__m128 rr = _mm_mul_ps(a.real, b.real), ii = _mm_mul_ps(a.imag, b.imag);
+			__m128 ir = _mm_mul_ps(a.imag, b.real), ri = _mm_mul_ps(a.real, b.imag);
+			return conjugateSecond ? SplitSse2Float{_mm_add_ps(rr, ii), _mm_sub_ps(ir, ri)} : SplitSse2Float{_mm_sub_ps(rr, ii), _mm_add_ps(ir, ri)};
+		}
+		template<bool flipped>
+		SIGNALSMITH_INLINE SplitSse2Float complexAddI(const SplitSse2Float &a, const SplitSse2Float &b) {
+			return flipped ? SplitSse2Float{_mm_add_ps(a.real, b.imag), _mm_sub_ps(a.imag, b.real)} : SplitSse2Float{_mm_sub_ps(a.real, b.imag), _mm_add_ps(a.imag, b.real)};
+		}
+
+		template<>
+		struct BatchAccess<float> {
+			static constexpr size_t lanes = 4;
+			using Value = SplitSse2Float;
+			static constexpr size_t width = 1;
+
+			static SIGNALSMITH_INLINE Value load(const std::complex<float> *data, size_t index) {
+				const float *values = reinterpret_cast<const float *>(data + index*lanes);
+				return {_mm_loadu_ps(values), _mm_loadu_ps(values + lanes)};
+			}
+			static SIGNALSMITH_INLINE void store(std::complex<float> *data, size_t index, const Value &value) {
+				float *values = reinterpret_cast<float *>(data + index*lanes);
+				_mm_storeu_ps(values, value.real);
+				_mm_storeu_ps(values + lanes, value.imag);
+			}
+			static SIGNALSMITH_INLINE Value twiddle(const std::complex<float> *twiddles, size_t index) {
+				const float *values = reinterpret_cast<const float *>(twiddles + index);
+				return {_mm_set1_ps(values[0]), _mm_set1_ps(values[1])};
+			}
+
+			// Converts between one value from each channel and the split format
+			static SIGNALSMITH_INLINE Value gather(const std::complex<float> * const *channels, size_t index) {
+				__m128 a = loadPair(channels[0] + index, channels[1] + index);
+				__m128 b = loadPair(channels[2] + index, channels[3] + index);
+				return {_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))};
+			}
+			static SIGNALSMITH_INLINE void scatter(const Value &value, std::complex<float> * const *channels, size_t index) {
+				storePair(channels[0] + index, channels[1] + index, _mm_unpacklo_ps(value.real, value.imag));
+				storePair(channels[2] + index, channels[3] + index, _mm_unpackhi_ps(value.real, value.imag));
+			}
+		};
+#endif
+
+		// Hints that memory will be needed soon (does nothing for iterators which aren't pointers)
+		template<typename Iterator>
+		SIGNALSMITH_INLINE void prefetch(Iterator) {}
+		template<typename T>
+		SIGNALSMITH_INLINE void prefetch(T *pointer) {
+#if defined(__GNUC__)
+			__builtin_prefetch(pointer);
+#elif defined(SIGNALSMITH_FFT_SSE2)
+			_mm_prefetch(reinterpret_cast<const char *>(pointer), _MM_HINT_T0);
+#else
+			(void)pointer;
+#endif
+		}
+
+		// Runs a kernel for butterflies [0, count), using the widest access available for the iterator type
+		template<class Kernel, typename V, typename RandomAccessIterator>
+		struct Butterflies {
+			static SIGNALSMITH_INLINE void run(RandomAccessIterator data, const std::complex<V> *twiddles, size_t stride, size_t count) {
+				Kernel::template run<ScalarAccess<V>>(data, twiddles, stride, 0, count);
+			}
+		};
+#ifdef SIGNALSMITH_FFT_SSE2
+		template<class Kernel>
+		struct Butterflies<Kernel, double, std::complex<double> *> {
+			static SIGNALSMITH_INLINE void run(std::complex<double> *data, const std::complex<double> *twiddles, size_t stride, size_t count) {
+				size_t index = 0;
+#ifdef SIGNALSMITH_FFT_AVX
+				index = count - count%AvxAccess::width;
+				Kernel::template run<AvxAccess>(data, twiddles, stride, 0, index);
+#endif
+				Kernel::template run<Sse2Access>(data, twiddles, stride, index, count);
+			}
+		};
+		template<class Kernel>
+		struct Butterflies<Kernel, float, std::complex<float> *> {
+			static SIGNALSMITH_INLINE void run(std::complex<float> *data, const std::complex<float> *twiddles, size_t stride, size_t count) {
+				size_t index = 0;
+#ifdef SIGNALSMITH_FFT_AVX
+				index = count - count%AvxFloatAccess::width;
+				Kernel::template run<AvxFloatAccess>(data, twiddles, stride, 0, index);
+#endif
+				size_t pairEnd = count - count%Sse2FloatAccess::width;
+				Kernel::template run<Sse2FloatAccess>(data, twiddles, stride, index, pairEnd);
+				Kernel::template run<ScalarAccess<float>>(data, twiddles, stride, pairEnd, count);
+			}
+		};
+#endif
+
+		// The widest access for kernels which read from one buffer and write to another (so both have to be contiguous)
+		template<typename V, typename InputIterator, typename OutputIterator>
+		struct WideAccess {
+			using type = ScalarAccess<V>;
+		};
+#ifdef SIGNALSMITH_FFT_SSE2
+		template<>
+		struct WideAccess<double, const std::complex<double> *, std::complex<double> *> {
+#ifdef SIGNALSMITH_FFT_AVX
+			using type = AvxAccess;
+#else
+			using type = Sse2Access;
+#endif
+		};
+		template<>
+		struct WideAccess<float, const std::complex<float> *, std::complex<float> *> {
+#ifdef SIGNALSMITH_FFT_AVX
+			using type = AvxFloatAccess;
+#else
+			using type = Sse2FloatAccess;
+#endif
+		};
+		template<typename V>
+		struct WideAccess<V, std::complex<V> *, std::complex<V> *> : public WideAccess<V, const std::complex<V> *, std::complex<V> *> {};
+#endif
+
+		// Runs a kernel for butterflies [0, count) in each of several repeats, which are `repeatStride` apart
+		template<class Kernel, typename V, typename RandomAccessIterator>
+		struct ButterflyRepeats {
+			static SIGNALSMITH_INLINE void run(RandomAccessIterator data, const std::complex<V> *twiddles, size_t stride, size_t count, size_t repeats, size_t repeatStride) {
+				// Not `data += repeatStride`, which would step some iterators (e.g. std::deque's) past the end
+				for (size_t repeat = 0; repeat < repeats; ++repeat) {
+					Butterflies<Kernel, V, RandomAccessIterator>::run(data + repeat*repeatStride, twiddles, stride, count);
+				}
+			}
+		};
+#ifdef SIGNALSMITH_FFT_SSE2
+		// A complex<float> vector holds more butterflies than the first steps have, so those take each SIMD lane from a different repeat
+		template<class Kernel>
+		struct ButterflyRepeats<Kernel, float, std::complex<float> *> {
+#ifdef SIGNALSMITH_FFT_AVX
+			using RepeatAccess = AvxFloatRepeatAccess;
+#else
+			using RepeatAccess = Sse2FloatRepeatAccess;
+#endif
+			static SIGNALSMITH_INLINE void run(std::complex<float> *data, const std::complex<float> *twiddles, size_t stride, size_t count, size_t repeats, size_t repeatStride) {
+				size_t repeat = 0;
+				if (count < RepeatAccess::repeats) {
+					for (; repeat + RepeatAccess::repeats <= repeats; repeat += RepeatAccess::repeats) {
+						Kernel::template run<RepeatAccess>(RepeatPointer<float>{data, repeatStride}, twiddles, stride, 0, count);
+						data += repeatStride*RepeatAccess::repeats;
+					}
+				}
+				for (; repeat < repeats; ++repeat) {
+					Butterflies<Kernel, float, std::complex<float> *>::run(data, twiddles, stride, count);
+					data += repeatStride;
+				}
+			}
+		};
+#endif
+	}
+	
+	// Use SFINAE to get an iterator from std::begin(), if supported - otherwise assume the value itself is an iterator
+	template<typename T, typename=void>
+	struct GetIterator {
+		static T get(const T &t) {
+			return t;
+		}
+	};
+	template<typename T>
+	struct GetIterator<T, decltype((void)std::begin(std::declval<T>()))> {
+		static auto get(const T &t) -> decltype(std::begin(t)) {
+			return std::begin(t);
+		}
+	};
+
+	// Runs independent tasks, possibly in parallel (see `FFT::setExecutor()`)
+	struct FFTExecutor {
+		virtual ~FFTExecutor() {}
+		// How many tasks can usefully run at once
+		virtual size_t concurrency() const = 0;
+		// Calls `task(i)` for each `i` in [0, count), and returns when they've all finished
+		virtual void parallelFor(size_t count, const std::function<void(size_t)> &task) = 0;
+	};
+
+	// A fixed set of worker threads, with the calling thread also taking part.
+	// If it's already busy (e.g. `parallelFor()` is called from inside a task, or from another thread), the tasks run on the calling thread instead.
+	class FFTThreadPool : public FFTExecutor {
+		std::vector<std::thread> workers;
+		std::atomic<bool> running{false};
+
+		std::mutex mutex;
+		std::condition_variable wake, finished;
+		const std::function<void(size_t)> *task = nullptr;
+		// Every worker takes part in each generation (even if there's nothing left to do), so `task` is only cleared once none of them can still be reading it
+		size_t taskCount = 0, generation = 0, pendingWorkers = 0;
+		bool stopping = false;
+		std::atomic<size_t> nextTask{0};
+
+		void runTasks(const std::function<void(size_t)> *task, size_t count) {
+			size_t index;
+			while ((index = nextTask++) < count) (*task)(index);
+		}
+		void workerLoop() {
+			size_t seenGeneration = 0;
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				wake.wait(lock, [&]{return stopping || generation != seenGeneration;});
+				if (stopping) return;
+				seenGeneration = generation;
+				const std::function<void(size_t)> *currentTask = task;
+				size_t count = taskCount;
+				lock.unlock();
+				runTasks(currentTask, count);
+				lock.lock();
+				if (--pendingWorkers == 0) finished.notify_all();
+			}
+		}
+	public:
+		FFTThreadPool(size_t threads=std::thread::hardware_concurrency()) {
+			for (size_t i = 1; i < threads; ++i) {
+				workers.emplace_back([this]{workerLoop();});
+			}
+		}
+		~FFTThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (auto &thread : workers) thread.join();
+		}
+
+		size_t concurrency() const override {
+			return workers.size() + 1;
+		}
+		void parallelFor(size_t count, const std::function<void(size_t)> &task) override {
+			bool wasRunning = false;
+			if (count <= 1 || workers.empty() || !running.compare_exchange_strong(wasRunning, true)) {
+				for (size_t i = 0; i < count; ++i) task(i);
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				this->task = &task;
+				taskCount = count;
+				nextTask = 0;
+				pendingWorkers = workers.size();
+				++generation;
+			}
+			wake.notify_all();
+			runTasks(&task, count);
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				finished.wait(lock, [&]{return pendingWorkers == 0;});
+				this->task = nullptr;
+			}
+			running = false;
+		}
+	};
+
+	// The default allocator for all internal buffers, aligned to cache lines so that SIMD loads never straddle two lines
+	template<typename T, size_t alignment=64>
+	struct FFTAllocator {
+		static_assert(alignment >= sizeof(void *) && (alignment&(alignment - 1)) == 0, "alignment must be a power of 2");
+		using value_type = T;
+		template<typename U>
+		struct rebind {
+			using other = FFTAllocator<U, alignment>;
+		};
+
+		FFTAllocator() {}
+		template<typename U>
+		FFTAllocator(const FFTAllocator<U, alignment> &) {}
+
+		T * allocate(size_t n) {
+			// Over-allocate, and keep the original pointer just before the aligned block
+			char *raw = (char *)::operator new(n*sizeof(T) + alignment + sizeof(void *));
+			uintptr_t aligned = ((uintptr_t)(raw + sizeof(void *)) + alignment - 1)&~(uintptr_t)(alignment - 1);
+			((void **)aligned)[-1] = raw;
+			return (T *)aligned;
+		}
+		void deallocate(T *pointer, size_t) {
+			::operator delete(((void **)pointer)[-1]);
+		}
+
+		template<typename U>
+		bool operator==(const FFTAllocator<U, alignment> &) const {
+			return true;
+		}
+		template<typename U>
+		bool operator!=(const FFTAllocator<U, alignment> &) const {
+			return false;
+		}
+	};
+
+	template<typename V, class Allocator=FFTAllocator<std::complex<V>>>
+	class FFT;
+
+	// How a plan breaks its size into steps, which `FFTPlan::measure()` can tune for the current machine
+	struct FFTPlanShape {
+		std::vector<size_t> radices; // Outermost step first.  Each is a prime, or 4/8/16.
+		size_t splitBytes = 65536; // Sub-FFTs bigger than this are planned (and threaded) separately
+		bool splitRadix = false; // Power-of-2 sizes only: uses the split-radix algorithm instead of the radix steps
+		bool stockham = false; // Radices 2/3/4/5/8/16 only: self-sorting steps which alternate between the output and a scratch buffer, so there's no permutation
+		bool sixStep = false; // Large sizes only: the six-step algorithm, which plans its own sub-FFTs (so the fields above are only used if it's not possible)
+
+		FFTPlanShape() {}
+		FFTPlanShape(const std::vector<size_t> &radices, size_t splitBytes=65536, bool splitRadix=false, bool stockham=false, bool sixStep=false) : radices(radices), splitBytes(splitBytes), splitRadix(splitRadix), stockham(stockham), sixStep(sixStep) {}
+	};
+
+	// The tables for one size of FFT (steps, twiddles, permutation etc.), which don't change after construction.
+	// A plan can be shared between several `FFT`s (e.g. one per thread), which each hold only their own working memory.
+	template<typename V, class Allocator=FFTAllocator<std::complex<V>>>
+	class FFTPlan {
+		friend class FFT<V, Allocator>;
+		using complex = std::complex<V>;
+		// All the tables use the plan's allocator
+		template<typename T>
+		using Vector = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+		Allocator allocator;
+		size_t _size;
+
+		enum class StepType {
+			generic, step2, step3, step4, step5, step8, step16, rader,
+			split // Marks the start of `factor` independent sub-FFTs, which come next in the plan
+		};
+		struct Step {
+			StepType type;
+			size_t factor;
+			size_t startIndex;
+			size_t innerRepeats;
+			size_t outerRepeats;
+			size_t twiddleIndex;
+			size_t rootIndex; // Generic steps only: the roots of unity for this factor
+			size_t raderIndex; // Rader steps only
+			size_t planLength; // Split steps only: the number of plan steps for each sub-FFT
+		};
+		FFTPlanShape _shape;
+		Vector<size_t> factors{allocator}; // The radices, with 4 as 2*2
+		Vector<Step> steps{allocator};
+		Vector<complex> twiddleVector{allocator};
+
+		std::shared_ptr<const FFTPlan> makePlan(size_t size) const {
+			return std::allocate_shared<FFTPlan>(allocator, size, allocator);
+		}
+
+		// Cyclic convolution with a fixed kernel, computed using a nested FFT (the working buffers are in `FFT::Convolution`)
+		struct ConvolutionKernel {
+			std::shared_ptr<const FFTPlan> fftPlan;
+			Vector<complex> spectrum;
+
+			explicit ConvolutionKernel(const Allocator &allocator) : spectrum(allocator) {}
+
+			size_t size() const {
+				return spectrum.size();
+			}
+			// The kernel is the same size as the convolution
+			void set(const std::vector<complex> &kernel) {
+				Allocator allocator = spectrum.get_allocator();
+				fftPlan = std::allocate_shared<FFTPlan>(allocator, kernel.size(), allocator);
+				fftPlan->setCycles(); // The convolutions run in-place
+				spectrum.resize(kernel.size());
+				FFT<V, Allocator>(fftPlan, allocator).fft(kernel.data(), spectrum.data());
+				V scale = V(1)/size();
+				for (auto &value : spectrum) value *= scale;
+			}
+		};
+
+		// Prime factors at least this big use Rader's algorithm, which turns the butterfly into a cyclic convolution
+		static constexpr size_t raderMinimum = 64;
+		struct Rader {
+			size_t factor;
+			// Inputs are read in the order g^q, and outputs written in the order g^-q, for a primitive root g
+			Vector<size_t> inputIndices, outputIndices;
+			ConvolutionKernel convolution;
+
+			Rader(size_t factor, const Allocator &allocator) : factor(factor), inputIndices(factor - 1, 0, allocator), outputIndices(factor - 1, 0, allocator), convolution(allocator) {
+				size_t root = primitiveRoot(factor), inverseRoot = 1;
+				for (size_t i = 0; i < factor - 2; ++i) inverseRoot = (inverseRoot*root)%factor;
+				inputIndices[0] = outputIndices[0] = 1;
+				for (size_t q = 1; q < factor - 1; ++q) {
+					inputIndices[q] = (inputIndices[q - 1]*root)%factor;
+					outputIndices[q] = (outputIndices[q - 1]*inverseRoot)%factor;
+				}
+
+				size_t convolutionSize = raderConvolutionSize(factor);
+				std::vector<complex> kernel(convolutionSize);
+				for (size_t q = 0; q < factor - 1; ++q) {
+					double phase = -2*M_PI*outputIndices[q]/factor;
+					complex value = {(V)cos(phase), (V)sin(phase)};
+					kernel[q] = value;
+					// If padded, the kernel wraps around
+					if (q > 0) kernel[convolutionSize - (factor - 1) + q] = value;
+				}
+				convolution.set(kernel);
+			}
+
+			static size_t primitiveRoot(size_t prime) {
+				std::vector<size_t> divisors;
+				factorise(prime - 1, divisors);
+
+				for (size_t root = 2; root < prime; ++root) {
+					bool isPrimitive = true;
+					for (size_t i = 0; i < divisors.size(); ++i) {
+						if (i > 0 && divisors[i] == divisors[i - 1]) continue;
+						// root^((prime - 1)/divisor) must not be 1
+						size_t power = (prime - 1)/divisors[i], result = 1, base = root;
+						while (power) {
+							if (power&1) result = (result*base)%prime;
+							base = (base*base)%prime;
+							power >>= 1;
+						}
+						if (result == 1) {
+							isPrimitive = false;
+							break;
+						}
+					}
+					if (isPrimitive) return root;
+				}
+				return 1;
+			}
+		};
+		static size_t raderConvolutionSize(size_t factor) {
+			// If (factor - 1) isn't a fast size, we pad to a fast size
+			size_t convolutionSize = factor - 1;
+			if (sizeMinimum(convolutionSize) != convolutionSize) {
+				convolutionSize = sizeMinimum(2*factor - 3);
+			}
+			return convolutionSize;
+		}
+		Vector<Rader> raders{allocator};
+
+		// Bluestein's algorithm computes the whole transform as a convolution with a chirp, using a (padded) fast size
+		bool useBluestein = false;
+		Vector<complex> bluesteinChirp{allocator};
+		ConvolutionKernel bluesteinConvolution{allocator};
+
+		using BatchAccess = perf::BatchAccess<V>;
+		static constexpr size_t batchLanes = BatchAccess::lanes;
+
+		// Huge sizes use the six-step algorithm.  The data is a (rows x columns) matrix: we do FFTs down the columns, twiddle, then FFTs along the rows, and transpose.
+		// Each pass works through cache-sized blocks, so there are only a few passes through main memory (instead of one per step).
+		// It's only faster once the data is several times bigger than the L3 cache, so by default it's used where the normal plan's setup (seconds) and tables (hundreds of MB) are the bigger problem.  `measure()` tries it from `sixStepMeasureBytes`.
+		static constexpr size_t sixStepMinimumBytes = size_t(1)<<28;
+		static constexpr size_t sixStepMeasureBytes = size_t(1)<<24;
+		static constexpr size_t sixStepBlock = 16; // Columns processed together, so the memory access is in runs
+		static constexpr size_t sixStepPadding = 4; // Power-of-2 strides in the column buffer alias in the L1 cache
+		static constexpr size_t sixStepTile = 16; // For the in-place transpose
+		struct SixStep {
+			size_t rows = 0, columns = 0; // `columns` is a multiple of `rows`
+			std::shared_ptr<const FFTPlan> columnPlan, rowPlan; // Sizes `rows` and `columns`
+			// The twiddle for column c and frequency k is W^(c*k) = W^(hi*rows)*W^lo, where c*k = hi*rows + lo
+			Vector<complex> twiddlesLow, twiddlesHigh;
+			// The in-place transpose ends with a permutation of row-sized chunks (as cycles, like `Cycles`)
+			Vector<size_t> chunkCycleIndices, chunkCycleEnds;
+
+			explicit SixStep(const Allocator &allocator) : twiddlesLow(allocator), twiddlesHigh(allocator), chunkCycleIndices(allocator), chunkCycleEnds(allocator) {}
+
+			// Working memory for each task (see `FFTExecutor`), for a block of columns and the batch FFT
+			size_t bufferSize() const {
+				return sixStepBlock*(columns + sixStepPadding) + batchLanes*columns;
+			}
+		};
+		bool useSixStep = false;
+		SixStep sixStep{allocator};
+
+		// Split-radix plans don't have any `steps`.  The twiddles for length L are at [L/2, L): W^k and then W^3k, for k < L/4.
+		bool useSplitRadix = false;
+		Vector<complex> splitRadixTwiddles{allocator};
+
+		void setSplitRadix() {
+			perf::UnitRoots roots(_size);
+			splitRadixTwiddles.resize(_size);
+			for (size_t length = 4; length <= _size; length *= 2) {
+				size_t quarter = length/4, rootStride = _size/length;
+				complex *twiddles = splitRadixTwiddles.data() + length/2;
+				for (size_t k = 0; k < quarter; ++k) {
+					twiddles[k] = roots.get<V>(k*rootStride);
+					twiddles[quarter + k] = roots.get<V>(3*k*rootStride);
+				}
+			}
+		}
+
+		// Stockham plans don't have any `steps` or permutation.  Each stage splits the remaining length into `radix*groups`, and reads/writes butterflies which are `stride` apart (the product of the previous radices), so the outputs end up in order.
+		struct StockhamStage {
+			size_t radix, groups, stride;
+			size_t twiddleIndex; // W^(p*k) for k in [1, radix) and p < groups, where W is the root for the remaining length
+		};
+		bool useStockham = false;
+		Vector<StockhamStage> stockhamStages{allocator};
+
+		// Radices which have a natural-order DFT (see `FFT::dftRadix()`)
+		static bool smallRadix(size_t radix) {
+			return radix <= 5 || radix == 8 || radix == 16;
+		}
+		void setStockham() {
+			perf::UnitRoots roots(_size);
+			// The twiddles for each stage are (radix - 1)*groups, which add up to N - 1
+			twiddleVector.reserve(_size);
+			size_t length = _size, stride = 1;
+			for (size_t radix : _shape.radices) {
+				size_t groups = length/radix, rootStride = _size/length;
+				stockhamStages.push_back(StockhamStage{radix, groups, stride, twiddleVector.size()});
+				for (size_t k = 1; k < radix; ++k) {
+					for (size_t p = 0; p < groups; ++p) twiddleVector.push_back(roots.get<V>(p*k*rootStride));
+				}
+				length = groups;
+				stride *= radix;
+			}
+		}
+
+		template<class SizeVector>
+		static void factorise(size_t size, SizeVector &result) {
+			result.resize(0);
+			size_t f = 2;
+			while (size > 1) {
+				if (size%f == 0) {
+					result.push_back(f);
+					size /= f;
+				} else if (f > sqrt(size)) {
+					f = size;
+				} else {
+					++f;
+				}
+			}
+		}
+
+		// Rough operation counts (per element), to decide when Bluestein's algorithm is faster
+		static double mixedRadixCost(size_t size) {
+			std::vector<size_t> sizeFactors;
+			factorise(size, sizeFactors);
+			double cost = 2; // permutation
+			for (size_t factor : sizeFactors) {
+				if (factor == 2) {
+					cost += 4;
+				} else if (factor == 3) {
+					cost += 7;
+				} else if (factor == 5) {
+					cost += 11.5;
+				} else if (factor < raderMinimum) {
+					cost += 6 + 4.0*(factor - 1)*(factor - 1)/factor;
+				} else {
+					cost += (20.0*factor + convolutionCost(raderConvolutionSize(factor)))/factor;
+				}
+			}
+			return cost;
+		}
+		static double convolutionCost(size_t convolutionSize) {
+			return convolutionSize*(2*mixedRadixCost(convolutionSize) + 6);
+		}
+		static double bluesteinCost(size_t size) {
+			return (convolutionCost(sizeMinimum(2*size - 1)) + 12.0*size)/size;
+		}
+
+		bool setSixStep() {
+			// The largest `rows` where rows^2 divides the size, so the transpose can use square blocks
+			size_t rows = (size_t)std::sqrt((double)_size);
+			while (rows > 1 && _size%(rows*rows)) --rows;
+			if (rows < 64) return false;
+			size_t columns = _size/rows;
+
+			sixStep.rows = rows;
+			sixStep.columns = columns;
+			sixStep.columnPlan = makePlan(rows);
+			sixStep.rowPlan = makePlan(columns);
+			// These are run from several threads at once, so they can't need any working buffers
+			for (const FFTPlan *plan : {sixStep.columnPlan.get(), sixStep.rowPlan.get()}) {
+				if (plan->useBluestein || plan->useSixStep || !plan->raders.empty()) return false;
+				// Some of the columns/rows are transformed in-place
+				plan->setCycles();
+			}
+
+			sixStep.twiddlesLow.resize(rows);
+			for (size_t i = 0; i < rows; ++i) {
+				double phase = -2*M_PI*i/_size;
+				sixStep.twiddlesLow[i] = {(V)cos(phase), (V)sin(phase)};
+			}
+			sixStep.twiddlesHigh.resize(columns);
+			for (size_t i = 0; i < columns; ++i) {
+				double phase = -2*M_PI*i/columns;
+				sixStep.twiddlesHigh[i] = {(V)cos(phase), (V)sin(phase)};
+			}
+
+			// After transposing each square block, chunk (r*blocks + b) needs to move to (b*rows + r)
+			size_t blocks = columns/rows;
+			std::vector<bool> visited(columns);
+			for (size_t i = 0; i < columns; ++i) {
+				size_t index = i, start = sixStep.chunkCycleIndices.size();
+				while (!visited[index]) {
+					visited[index] = true;
+					sixStep.chunkCycleIndices.push_back(index);
+					index = (index%rows)*blocks + index/rows;
+				}
+				if (sixStep.chunkCycleIndices.size() > start + 1) {
+					sixStep.chunkCycleEnds.push_back(sixStep.chunkCycleIndices.size());
+				} else {
+					sixStep.chunkCycleIndices.resize(start);
+				}
+			}
+			return true;
+		}
+
+		void setBluestein() {
+			size_t convolutionSize = sizeMinimum(2*_size - 1);
+			bluesteinChirp.resize(_size);
+			perf::UnitRoots roots(2*_size);
+			for (size_t i = 0; i < _size; ++i) {
+				// Reduce i^2 mod 2N, so the phase is still accurate for large sizes
+				bluesteinChirp[i] = roots.get<V>((i*i)%(2*_size));
+			}
+
+			// The kernel is the conjugate chirp, symmetric around 0
+			std::vector<complex> kernel(convolutionSize);
+			kernel[0] = conj(bluesteinChirp[0]);
+			for (size_t i = 1; i < _size; ++i) {
+				kernel[i] = kernel[convolutionSize - i] = conj(bluesteinChirp[i]);
+			}
+			bluesteinConvolution.set(kernel);
+		}
+
+		struct PermutationPair {size_t from, to;};
+		// The permutation is a mixed-radix digit-reversal, so it's the sum of two small tables: pair `i` is `permutationInner[i%innerSize] + permutationOuter[i/innerSize]`
+		Vector<PermutationPair> permutationInner{allocator}, permutationOuter{allocator};
+		// The first step of the plan (if its radix is small) can be fused with the permutation, since its twiddles are all 1.
+		// These tables are for its butterflies: the outputs are contiguous from `from*firstRadix`, and the inputs are `to + k*_size/firstRadix`.
+		size_t firstRadix = 0;
+		Vector<PermutationPair> firstStepInner{allocator}, firstStepOuter{allocator};
+		// The same permutation as cycles, for in-place use: each element takes the value of the next one, and the last takes the (old) first value
+		template<typename Index>
+		struct Cycles {
+			Vector<Index> indices, ends;
+
+			explicit Cycles(const Allocator &allocator) : indices(allocator), ends(allocator) {}
+		};
+		// Indices are 32-bit when the size allows, which halves the memory (and bandwidth) for in-place transforms
+		// Only in-place transforms use these, so they're built on first use (see `setCycles()`).  The plan can be shared between threads, so this is locked.
+		mutable Cycles<uint32_t> cycles32{allocator};
+		mutable Cycles<size_t> cycles64{allocator};
+		mutable std::atomic<bool> hasCycles{false};
+		mutable std::mutex cyclesMutex;
+
+		void setCycles() const {
+			if (hasCycles.load(std::memory_order_acquire)) return;
+			std::lock_guard<std::mutex> lock(cyclesMutex);
+			if (hasCycles.load(std::memory_order_relaxed)) return;
+			// Bluestein, six-step and Stockham plans don't have a permutation
+			if (!permutationInner.empty()) {
+				if (_size <= UINT32_MAX) {
+					addCycles(cycles32);
+				} else {
+					addCycles(cycles64);
+				}
+			}
+			hasCycles.store(true, std::memory_order_release);
+		}
+		template<typename Index>
+		void addCycles(Cycles<Index> &cycles) const {
+			std::vector<Index> source(_size);
+			size_t moved = 0;
+			forEachPermutation(0, _size, [&](size_t from, size_t to) {
+				source[from] = (Index)to;
+				moved += (from != to);
+			});
+			cycles.indices.reserve(moved);
+			// Marking visited indices in a separate (much smaller) bitmap keeps the random accesses cheaper
+			std::vector<bool> visited(_size);
+			for (size_t i = 0; i < _size; ++i) {
+				if (visited[i] || source[i] == i) continue;
+				size_t index = i;
+				while (!visited[index]) {
+					cycles.indices.push_back((Index)index);
+					visited[index] = true;
+					index = source[index];
+				}
+				cycles.ends.push_back((Index)cycles.indices.size());
+			}
+		}
+
+		void addPlanSteps(const perf::UnitRoots &roots, size_t radixIndex, size_t start, size_t length, size_t repeats) {
+			if (radixIndex >= _shape.radices.size()) return;
+
+			size_t factor = _shape.radices[radixIndex];
+			size_t subLength = length/factor;
+			Step mainStep{StepType::generic, factor, start, subLength, repeats, twiddleVector.size(), 0, 0, 0};
+
+			if (factor == 2) mainStep.type = StepType::step2;
+			if (factor == 3) mainStep.type = StepType::step3;
+			if (factor == 4) mainStep.type = StepType::step4;
+			if (factor == 5) mainStep.type = StepType::step5;
+			if (factor == 8) mainStep.type = StepType::step8;
+			if (factor == 16) mainStep.type = StepType::step16;
+			if (factor >= raderMinimum) mainStep.type = StepType::rader;
+
+			// Twiddles
+			bool foundStep = false;
+			for (const Step &existingStep : steps) {
+				if (existingStep.type != StepType::split && existingStep.factor == mainStep.factor && existingStep.innerRepeats == mainStep.innerRepeats) {
+					foundStep = true;
+					mainStep.twiddleIndex = existingStep.twiddleIndex;
+					break;
+				}
+			}
+			if (!foundStep) {
+				// Twiddles for each (non-zero) input are contiguous, so the butterflies can be vectorised
+				size_t rootStride = _size/length;
+				for (size_t f = 1; f < factor; ++f) {
+					for (size_t i = 0; i < subLength; ++i) {
+						twiddleVector.push_back(roots.get<V>(i*f*rootStride));
+					}
+				}
+			}
+			if (mainStep.type == StepType::rader) {
+				mainStep.raderIndex = raders.size();
+				for (size_t i = 0; i < raders.size(); ++i) {
+					if (raders[i].factor == factor) mainStep.raderIndex = i;
+				}
+				if (mainStep.raderIndex == raders.size()) raders.emplace_back(factor, allocator);
+			}
+			if (mainStep.type == StepType::generic) {
+				bool foundRoots = false;
+				for (const Step &existingStep : steps) {
+					if (existingStep.type == StepType::generic && existingStep.factor == factor) {
+						foundRoots = true;
+						mainStep.rootIndex = existingStep.rootIndex;
+						break;
+					}
+				}
+				if (!foundRoots) {
+					mainStep.rootIndex = twiddleVector.size();
+					for (size_t f = 0; f < factor; ++f) {
+						twiddleVector.push_back(roots.get<V>(f*(_size/factor)));
+					}
+				}
+			}
+
+			if (repeats == 1 && sizeof(complex)*subLength > _shape.splitBytes) {
+				// The sub-FFTs all have the same steps (apart from `.startIndex`), so they can be run in parallel
+				size_t splitIndex = steps.size();
+				steps.push_back(Step{StepType::split, factor, start, subLength, 1, 0, 0, 0, 0});
+				for (size_t i = 0; i < factor; ++i) {
+					addPlanSteps(roots, radixIndex + 1, start + i*subLength, subLength, 1);
+				}
+				steps[splitIndex].planLength = (steps.size() - splitIndex - 1)/factor;
+			} else {
+				addPlanSteps(roots, radixIndex + 1, start, subLength, repeats*factor);
+			}
+			steps.push_back(mainStep);
+		}
+		// Bigger than this, the passes through memory cost more than the extra register pressure of radix-8 steps
+		static constexpr size_t radix8MinimumBytes = 1<<20;
+		// Smallest factors first, with 2s merged into radix-4 (or radix-8, for large sizes) steps.
+		// Radix-16 needs more than 16 SIMD registers, so it's only used if `measure()` finds it faster.
+		static FFTPlanShape defaultShape(size_t size) {
+			FFTPlanShape shape;
+			factorise(size, shape.radices);
+			size_t maxRadix = (sizeof(complex)*size >= radix8MinimumBytes) ? 8 : 4;
+			size_t i = 0;
+			for (size_t factor : shape.radices) {
+				if (factor == 2 && i > 0 && isPower2Radix(shape.radices[i - 1]*2) && shape.radices[i - 1] < maxRadix) {
+					shape.radices[i - 1] *= 2;
+				} else {
+					shape.radices[i++] = factor;
+				}
+			}
+			shape.radices.resize(i);
+			shape.sixStep = (sizeof(complex)*size >= sixStepMinimumBytes);
+			return shape;
+		}
+		// Combined radix-2 steps, which have their own butterflies
+		static bool isPower2Radix(size_t radix) {
+			return radix == 4 || radix == 8 || radix == 16;
+		}
+		bool validShape(const FFTPlanShape &shape) const {
+			size_t product = 1;
+			for (size_t radix : shape.radices) {
+				if (radix < 2 || _size%(product*radix)) return false;
+				if (!isPower2Radix(radix) && FFTPlan::factorise(radix).size() != 1) return false;
+				if (shape.stockham && !smallRadix(radix)) return false;
+				product *= radix;
+			}
+			return product == _size && (!shape.splitRadix || (_size&(_size - 1)) == 0) && !(shape.splitRadix && shape.stockham);
+		}
+		static std::vector<size_t> factorise(size_t size) {
+			std::vector<size_t> result;
+			factorise(size, result);
+			return result;
+		}
+
+		void setPlan() {
+			factorise(_size, factors);
+			if (!_size) return;
+			size_t largestFactor = factors.empty() ? 1 : factors.back();
+
+			useSixStep = _shape.sixStep && largestFactor < raderMinimum && setSixStep();
+			if (!useSixStep) {
+				sixStep = SixStep(allocator);
+				_shape.sixStep = false;
+			}
+
+			useBluestein = !useSixStep && largestFactor > 5 && bluesteinCost(_size) < mixedRadixCost(_size);
+			if (useBluestein) return setBluestein();
+			if (useSixStep) return;
+
+			useStockham = _shape.stockham;
+			if (useStockham) return setStockham();
+
+			factors.resize(0);
+			for (size_t radix : _shape.radices) {
+				if (isPower2Radix(radix)) {
+					for (size_t r = radix; r > 1; r /= 2) factors.push_back(2);
+				} else {
+					factors.push_back(radix);
+				}
+			}
+
+			// The split-radix algorithm uses the same (bit-reversal) permutation as the radix-2 steps
+			useSplitRadix = _shape.splitRadix;
+			if (useSplitRadix) {
+				setSplitRadix();
+			} else {
+				// Each step's twiddles are a subset of the N-th roots of unity.  There are just under N of them in total, plus each generic step's roots
+				size_t twiddleCount = _size;
+				for (size_t radix : _shape.radices) twiddleCount += radix;
+				twiddleVector.reserve(twiddleCount);
+				addPlanSteps(perf::UnitRoots(_size), 0, 0, _size, 1);
+				bool canThread = false;
+				for (const Step &step : steps) {
+					if (step.type == StepType::rader) {
+						canThread = false;
+						break;
+					}
+					if (step.type == StepType::split) canThread = true;
+				}
+				if (canThread) addThreadPhases(0, steps.size(), 1, 0);
+			}
+
+			setPermutation(factors.size(), _size, permutationInner, permutationOuter);
+			// The first step has no twiddles, so it can gather its inputs straight from the input.  This leaves a digit-reversal of the other factors.
+			if (!useSplitRadix && _size > 1 && smallRadix(_shape.radices.back())) {
+				firstRadix = _shape.radices.back();
+				size_t otherFactors = factors.size();
+				for (size_t radix = 1; radix < firstRadix; radix *= factors[--otherFactors]) {}
+				setPermutation(otherFactors, _size/firstRadix, firstStepInner, firstStepOuter);
+			}
+		}
+
+		// Fills the digit tables for the digit-reversal of `factors[0, factorCount)`, whose product is `size`
+		void setPermutation(size_t factorCount, size_t size, Vector<PermutationPair> &inner, Vector<PermutationPair> &outer) {
+			// Each digit of the permutation moves by `inputStep` in the data and `outputStep` in the input, alternating between both ends of the factor list
+			std::vector<PermutationPair> digitSteps;
+			std::vector<size_t> digitFactors;
+			size_t indexLow = 0, indexHigh = factorCount;
+			size_t inputStepLow = size, outputStepLow = 1;
+			size_t inputStepHigh = 1, outputStepHigh = size;
+			while (outputStepLow*inputStepHigh < size) {
+				size_t f, inputStep, outputStep;
+				if (outputStepLow <= inputStepHigh) {
+					f = factors[indexLow++];
+					inputStep = (inputStepLow /= f);
+					outputStep = outputStepLow;
+					outputStepLow *= f;
+				} else {
+					f = factors[--indexHigh];
+					inputStep = inputStepHigh;
+					inputStepHigh *= f;
+					outputStep = (outputStepHigh /= f);
+				}
+				digitFactors.push_back(f);
+				digitSteps.push_back(PermutationPair{inputStep, outputStep});
+			}
+			// The first (fastest-changing) digits go in the inner table, until it's at least sqrt(N) long
+			size_t innerDigits = 0, innerSize = 1;
+			while (innerDigits < digitFactors.size() && innerSize*innerSize < size) {
+				innerSize *= digitFactors[innerDigits++];
+			}
+			auto addDigits = [&](Vector<PermutationPair> &table, size_t fromDigit, size_t toDigit) {
+				table.push_back(PermutationPair{0, 0});
+				for (size_t d = fromDigit; d < toDigit; ++d) {
+					size_t oldSize = table.size();
+					for (size_t i = 1; i < digitFactors[d]; ++i) {
+						for (size_t j = 0; j < oldSize; ++j) {
+							PermutationPair pair = table[j];
+							pair.from += i*digitSteps[d].from;
+							pair.to += i*digitSteps[d].to;
+							table.push_back(pair);
+						}
+					}
+				}
+			};
+			addDigits(inner, 0, innerDigits);
+			addDigits(outer, innerDigits, digitFactors.size());
+		}
+
+		// For threaded execution, the plan is grouped into phases, each of which is a set of independent tasks
+		struct ThreadPhase {
+			size_t begin, end; // Range of plan steps
+			size_t copies, copyStride; // The steps are repeated for each copy, offset by `copyStride`
+			bool whole; // Each copy runs all the steps as one task, otherwise it's a single step split into chunks
+		};
+		Vector<ThreadPhase> threadPhases{allocator};
+
+		void addThreadPhases(size_t begin, size_t end, size_t copies, size_t copyStride) {
+			bool hasSplit = false;
+			for (size_t i = begin; i < end; ++i) {
+				if (steps[i].type == StepType::split) hasSplit = true;
+			}
+			if (!hasSplit && copies > 1) {
+				// Small enough to run each sub-FFT on a single thread
+				threadPhases.push_back(ThreadPhase{begin, end, copies, copyStride, true});
+				return;
+			}
+			size_t i = begin;
+			while (i < end) {
+				const Step &step = steps[i];
+				if (step.type == StepType::split) {
+					// Only the first sub-FFT's steps are used, with the copies multiplied up
+					size_t subBegin = i + 1, subEnd = subBegin + step.planLength;
+					addThreadPhases(subBegin, subEnd, copies*step.factor, step.innerRepeats);
+					i = subBegin + step.factor*step.planLength;
+				} else {
+					threadPhases.push_back(ThreadPhase{i, i + 1, copies, copyStride, false});
+					++i;
+				}
+			}
+		}
+
+		// Orderings of the factors to try when measuring: 2s as radix-4/8/16 (with any remainder first or last) or radix-2, before or after the other factors (ascending or descending)
+		static std::vector<std::vector<size_t>> candidateRadices(size_t size) {
+			std::vector<size_t> powers2, others;
+			for (size_t factor : factorise(size)) {
+				(factor == 2 ? powers2 : others).push_back(factor);
+			}
+			std::vector<std::vector<size_t>> powerGroups{powers2};
+			for (size_t bits = 2; bits <= 4 && powers2.size() >= bits; ++bits) {
+				std::vector<size_t> merged(powers2.size()/bits, size_t(1) << bits);
+				if (size_t remainder = powers2.size()%bits) {
+					std::vector<size_t> remainderFirst{size_t(1) << remainder};
+					remainderFirst.insert(remainderFirst.end(), merged.begin(), merged.end());
+					powerGroups.push_back(remainderFirst);
+					merged.push_back(size_t(1) << remainder);
+				}
+				powerGroups.push_back(merged);
+			}
+			std::vector<std::vector<size_t>> otherGroups{others};
+			std::vector<size_t> descending(others.rbegin(), others.rend());
+			if (descending != others) otherGroups.push_back(descending);
+
+			std::vector<std::vector<size_t>> result;
+			for (auto &powerGroup : powerGroups) {
+				for (auto &otherGroup : otherGroups) {
+					for (bool powersFirst : {true, false}) {
+						std::vector<size_t> radices = powersFirst ? powerGroup : otherGroup;
+						const auto &second = powersFirst ? otherGroup : powerGroup;
+						radices.insert(radices.end(), second.begin(), second.end());
+						if (std::find(result.begin(), result.end(), radices) == result.end()) {
+							result.push_back(radices);
+						}
+					}
+				}
+			}
+			return result;
+		}
+		// Best (shortest) time per transform, from a few runs
+		static double measureTime(std::shared_ptr<const FFTPlan> plan, const std::vector<complex> &input, std::vector<complex> &output, double seconds) {
+			using Clock = std::chrono::steady_clock;
+			FFT<V, Allocator> fft(plan, plan->allocator);
+			fft.fft(input, output); // warm-up
+			double bestTime = -1;
+			for (int run = 0; run < 3; ++run) {
+				size_t repeats = 0;
+				auto start = Clock::now();
+				double elapsed;
+				do {
+					for (size_t i = 0; i <= repeats; ++i) fft.fft(input, output);
+					repeats += repeats + 1;
+					elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+				} while (elapsed < seconds/3);
+				double time = elapsed/repeats;
+				if (bestTime < 0 || time < bestTime) bestTime = time;
+			}
+			return bestTime;
+		}
+
+		static bool validSize(size_t size) {
+			constexpr static bool filter[32] = {
+				1, 1, 1, 1, 1, 0, 1, 0, 1, 1, // 0-9
+				0, 0, 1, 0, 0, 0, 1, 0, 1, 0, // 10-19
+				0, 0, 0, 0, 1, 0, 0, 0, 0, 0, // 20-29
+				0, 0
+			};
+			return filter[size];
+		}
+	public:
+		static size_t sizeMinimum(size_t size) {
+			size_t power2 = 1;
+			while (size >= 32) {
+				size = (size - 1)/2 + 1;
+				power2 *= 2;
+			}
+			while (size < 32 && !validSize(size)) {
+				++size;
+			}
+			return power2*size;
+		}
+		static size_t sizeMaximum(size_t size) {
+			size_t power2 = 1;
+			while (size >= 32) {
+				size /= 2;
+				power2 *= 2;
+			}
+			while (size > 1 && !validSize(size)) {
+				--size;
+			}
+			return power2*size;
+		}
+
+		FFTPlan(size_t size, const Allocator &allocator=Allocator()) : allocator(allocator), _size(size), _shape(defaultShape(size)) {
+			setPlan();
+		}
+		// If the shape doesn't match the size, the default shape is used
+		FFTPlan(size_t size, const FFTPlanShape &shape, const Allocator &allocator=Allocator()) : allocator(allocator), _size(size), _shape(shape) {
+			if (!validShape(shape)) _shape = defaultShape(size);
+			setPlan();
+		}
+
+		// Times some alternative shapes (factor orders, radix-2/4/8/16, split sizes, split-radix, Stockham, six-step) on this machine, and returns the fastest
+		static std::shared_ptr<const FFTPlan> measure(size_t size, double secondsPerShape=0.002, const Allocator &allocator=Allocator()) {
+			auto best = std::allocate_shared<FFTPlan>(allocator, size, allocator);
+			// Bluestein plans don't use the shape
+			if (size < 4 || best->useBluestein) return best;
+			std::vector<complex> input(size), output(size);
+			for (size_t i = 0; i < size; ++i) input[i] = {V(i%7) - 3, V(i%5) - 2};
+			double bestTime = measureTime(best, input, output, secondsPerShape);
+
+			auto tryShape = [&](const FFTPlanShape &shape) {
+				auto plan = std::allocate_shared<FFTPlan>(allocator, size, shape, allocator);
+				double time = measureTime(plan, input, output, secondsPerShape);
+				if (time < bestTime) {
+					best = plan;
+					bestTime = time;
+				}
+			};
+			// Huge sizes only compare six-step with the default shape, since each normal plan takes a long time to set up
+			if (sizeof(complex)*size >= sixStepMeasureBytes) {
+				FFTPlanShape shape = best->_shape;
+				shape.sixStep = !shape.sixStep;
+				tryShape(shape);
+				return best;
+			}
+			// Factor orders first, then the split size for the fastest one
+			std::vector<std::vector<size_t>> radixOrders = candidateRadices(size);
+			for (auto &radices : radixOrders) {
+				if (radices != best->_shape.radices) tryShape(FFTPlanShape{radices, best->_shape.splitBytes});
+			}
+			if (sizeof(complex)*size > 16384) {
+				std::vector<size_t> radices = best->_shape.radices;
+				for (size_t splitBytes : {size_t(16384), size_t(32768), size_t(65536), size_t(131072), size_t(262144), size_t(-1)}) {
+					if (splitBytes != best->_shape.splitBytes) tryShape(FFTPlanShape{radices, splitBytes});
+				}
+			}
+			if ((size&(size - 1)) == 0) tryShape(FFTPlanShape{best->_shape.radices, best->_shape.splitBytes, true});
+			bool smallRadices = true;
+			for (size_t radix : best->_shape.radices) smallRadices = smallRadices && smallRadix(radix);
+			if (smallRadices) tryShape(FFTPlanShape{best->_shape.radices, best->_shape.splitBytes, false, true});
+			return best;
+		}
+
+		const size_t & size() const {
+			return _size;
+		}
+		const FFTPlanShape & shape() const {
+			return _shape;
+		}
+
+		// In-place transforms need an extra table, which is otherwise built (and allocated) by the first one
+		void prepareInPlace() const {
+			setCycles();
+		}
+
+		// Fills `indices` so that bin `i` is at `indices[i]` in the unordered spectrum
+		template<typename RandomAccessIterator>
+		void unorderedIndices(RandomAccessIterator &&indices) const {
+			if (useBluestein || useStockham) {
+				for (size_t i = 0; i < _size; ++i) indices[i] = i;
+				return;
+			}
+			if (useSixStep) {
+				const size_t rows = sixStep.rows, columns = sixStep.columns;
+				for (size_t i = 0; i < _size; ++i) indices[i] = (i%rows)*columns + i/rows;
+				return;
+			}
+			forEachPermutation(0, _size, [&](size_t from, size_t to) {
+				indices[to] = from;
+			});
+		}
+
+		// Calls `fn(from, to)` for pairs [begin, end) of the permutation
+		template<class Fn>
+		SIGNALSMITH_INLINE void forEachPermutation(size_t begin, size_t end, Fn &&fn) const {
+			forEachPair(permutationInner, permutationOuter, begin, end, fn);
+		}
+		// The same for the fused first step, for butterflies [begin, end)
+		template<class Fn>
+		SIGNALSMITH_INLINE void forEachFirstStep(size_t begin, size_t end, Fn &&fn) const {
+			forEachPair(firstStepInner, firstStepOuter, begin, end, fn);
+		}
+		template<class Fn>
+		static SIGNALSMITH_INLINE void forEachPair(const Vector<PermutationPair> &innerTable, const Vector<PermutationPair> &outerTable, size_t begin, size_t end, Fn &fn) {
+			if (begin >= end) return;
+			const size_t innerSize = innerTable.size();
+			const PermutationPair *inner = innerTable.data();
+			for (size_t o = begin/innerSize; begin < end; ++o) {
+				const PermutationPair outer = outerTable[o];
+				size_t i = begin - o*innerSize, iEnd = std::min(innerSize, end - o*innerSize);
+				for (; i < iEnd; ++i) {
+					fn(outer.from + inner[i].from, outer.to + inner[i].to);
+				}
+				begin = (o + 1)*innerSize;
+			}
+		}
+	};
+
+	template<typename V, size_t N>
+	class FixedFFT;
+
+	template<typename V, class Allocator>
+	class FFT {
+		template<typename, size_t>
+		friend class FixedFFT;
+		using complex = std::complex<V>;
+		using Plan = FFTPlan<V, Allocator>;
+		template<typename T>
+		using Vector = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+		using StepType = typename Plan::StepType;
+		using Step = typename Plan::Step;
+		using ThreadPhase = typename Plan::ThreadPhase;
+		using PermutationPair = typename Plan::PermutationPair;
+		static constexpr size_t raderMinimum = Plan::raderMinimum;
+		static constexpr size_t sixStepBlock = Plan::sixStepBlock;
+		static constexpr size_t sixStepPadding = Plan::sixStepPadding;
+		static constexpr size_t sixStepTile = Plan::sixStepTile;
+
+		Allocator allocator;
+		std::shared_ptr<const Plan> _plan;
+		size_t _size;
+
+		// Nested FFTs are allocated with the allocator as well
+		struct FFTDeleter {
+			Allocator allocator;
+			void operator()(FFT *fft) {
+				typename std::allocator_traits<Allocator>::template rebind_alloc<FFT> fftAllocator(allocator);
+				fft->~FFT();
+				fftAllocator.deallocate(fft, 1);
+			}
+		};
+		using FFTPointer = std::unique_ptr<FFT, FFTDeleter>;
+		template<class... Args>
+		static FFTPointer newFft(const Allocator &allocator, Args &&...args) {
+			typename std::allocator_traits<Allocator>::template rebind_alloc<FFT> fftAllocator(allocator);
+			FFT *fft = fftAllocator.allocate(1);
+			new (fft) FFT(std::forward<Args>(args)...);
+			return FFTPointer(fft, FFTDeleter{allocator});
+		}
+
+		// Working buffers for a `Plan::ConvolutionKernel`
+		struct Convolution {
+			FFTPointer fft;
+			// The FFTs run in-place, so this is the only buffer
+			Vector<complex> buffer;
+
+			explicit Convolution(const Allocator &allocator) : fft(nullptr, FFTDeleter{allocator}), buffer(allocator) {}
+			Convolution(const Convolution &other) : Convolution(other.buffer.get_allocator()) {
+				*this = other;
+			}
+			Convolution(Convolution &&other) = default;
+			Convolution & operator=(Convolution &&other) = default;
+			Convolution & operator=(const Convolution &other) {
+				Allocator allocator = buffer.get_allocator();
+				fft = other.fft ? newFft(allocator, *other.fft) : FFTPointer(nullptr, FFTDeleter{allocator});
+				buffer = other.buffer;
+				return *this;
+			}
+
+			void setKernel(const typename Plan::ConvolutionKernel &kernel) {
+				Allocator allocator = buffer.get_allocator();
+				fft = newFft(allocator, kernel.fftPlan, allocator);
+				buffer.resize(kernel.size());
+			}
+
+			// Convolves `buffer` in-place, optionally with the conjugate of the kernel
+			template<bool conjugateKernel>
+			void run(const typename Plan::ConvolutionKernel &convolutionKernel) {
+				const size_t size = buffer.size();
+				complex *spectrum = buffer.data();
+				const complex *kernel = convolutionKernel.spectrum.data();
+				fft->fft(spectrum);
+				if (conjugateKernel) {
+					// Conjugating the kernel conjugates and reverses its spectrum
+					spectrum[0] = perf::complexMul<true>(spectrum[0], kernel[0]);
+					for (size_t i = 1; i < size; ++i) {
+						spectrum[i] = perf::complexMul<true>(spectrum[i], kernel[size - i]);
+					}
+				} else {
+					for (size_t i = 0; i < size; ++i) {
+						spectrum[i] = perf::complexMul<false>(spectrum[i], kernel[i]);
+					}
+				}
+				fft->ifft(spectrum);
+			}
+		};
+		Vector<Convolution> raderConvolutions{allocator};
+		Convolution bluesteinConvolution{allocator};
+
+		struct SixStepWork {
+			// The sub-FFTs are shared between threads, so they can't have any working buffers (see `Plan::setSixStep()`)
+			FFTPointer columnFft, rowFft;
+			// Each task (see `FFTExecutor`) has its own section, of size `Plan::SixStep::bufferSize()`
+			Vector<complex> buffer;
+
+			explicit SixStepWork(const Allocator &allocator) : columnFft(nullptr, FFTDeleter{allocator}), rowFft(nullptr, FFTDeleter{allocator}), buffer(allocator) {}
+			SixStepWork(const SixStepWork &other) : SixStepWork(other.buffer.get_allocator()) {
+				*this = other;
+			}
+			SixStepWork(SixStepWork &&other) = default;
+			SixStepWork & operator=(SixStepWork &&other) = default;
+			SixStepWork & operator=(const SixStepWork &other) {
+				Allocator allocator = buffer.get_allocator();
+				columnFft = other.columnFft ? newFft(allocator, *other.columnFft) : FFTPointer(nullptr, FFTDeleter{allocator});
+				rowFft = other.rowFft ? newFft(allocator, *other.rowFft) : FFTPointer(nullptr, FFTDeleter{allocator});
+				buffer = other.buffer;
+				return *this;
+			}
+		};
+		SixStepWork sixStepWork{allocator};
+		// Stockham plans alternate between this and the output
+		Vector<complex> stockhamBuffer{allocator};
+
+		void setWorkingMemory() {
+			raderConvolutions.clear();
+			for (const auto &rader : _plan->raders) {
+				raderConvolutions.emplace_back(allocator);
+				raderConvolutions.back().setKernel(rader.convolution);
+			}
+			if (_plan->useBluestein) {
+				bluesteinConvolution.setKernel(_plan->bluesteinConvolution);
+			} else {
+				bluesteinConvolution = Convolution(allocator);
+			}
+			stockhamBuffer.resize(_plan->useStockham ? _size : 0);
+			sixStepWork = SixStepWork(allocator);
+			if (_plan->useSixStep) {
+				sixStepWork.columnFft = newFft(allocator, _plan->sixStep.columnPlan, allocator);
+				sixStepWork.rowFft = newFft(allocator, _plan->sixStep.rowPlan, allocator);
+				sixStepWork.buffer.resize(sixStepBufferSize(*_plan));
+			}
+		}
+		// Threaded six-step transforms use a separate section of the buffer for each task
+		size_t sixStepBufferSize(const Plan &plan) const {
+			size_t tasks = (executor && executor->concurrency() > 1) ? executor->concurrency() : 1;
+			return plan.useSixStep ? tasks*plan.sixStep.bufferSize() : 0;
+		}
+
+		// A plan and its working memory, prepared by `reserve()`.  Switching sizes swaps these with the current ones, so it doesn't allocate.
+		struct Reserved {
+			std::shared_ptr<const Plan> plan;
+			Vector<Convolution> raderConvolutions;
+			Convolution bluesteinConvolution;
+			SixStepWork sixStepWork;
+			Vector<complex> stockhamBuffer;
+
+			explicit Reserved(const Allocator &allocator) : raderConvolutions(allocator), bluesteinConvolution(allocator), sixStepWork(allocator), stockhamBuffer(allocator) {}
+		};
+		Vector<Reserved> reserved{allocator};
+		// Whether the current plan was reserved, so it has to be kept when switching away
+		bool currentReserved = false;
+
+		void swapReserved(Reserved &other) {
+			std::swap(_plan, other.plan);
+			std::swap(raderConvolutions, other.raderConvolutions);
+			std::swap(bluesteinConvolution, other.bluesteinConvolution);
+			std::swap(sixStepWork, other.sixStepWork);
+			std::swap(stockhamBuffer, other.stockhamBuffer);
+			_size = _plan ? _plan->size() : 0;
+		}
+
+
+		// Decimation-in-time steps twiddle their inputs.  The transposed (decimation-in-frequency) steps instead twiddle their outputs, and run in reverse order.
+		template<bool inverse, bool dif, class Access, typename RandomAccessIterator>
+		static SIGNALSMITH_INLINE typename Access::Value loadTwiddled(RandomAccessIterator data, size_t index, const complex *twiddles, size_t twiddleIndex) {
+			typename Access::Value value = Access::load(data, index);
+			return dif ? value : perf::complexMul<inverse>(value, Access::twiddle(twiddles, twiddleIndex));
+		}
+		template<bool inverse, bool dif, class Access, typename RandomAccessIterator>
+		static SIGNALSMITH_INLINE void storeTwiddled(RandomAccessIterator data, size_t index, typename Access::Value value, const complex *twiddles, size_t twiddleIndex) {
+			Access::store(data, index, dif ? perf::complexMul<inverse>(value, Access::twiddle(twiddles, twiddleIndex)) : value);
+		}
+
+		template<bool inverse, bool dif, typename RandomAccessIterator>
+		void fftStepGeneric(RandomAccessIterator origData, const Step &step, size_t from, size_t to) {
+			using Access = perf::ScalarAccess<V>;
+			// The factor is always an odd prime (below `raderMinimum`), because 2s are handled by the radix-2/4/8/16 steps
+			const size_t factor = step.factor, halfFactor = factor/2;
+			const size_t stride = step.innerRepeats;
+			const complex *roots = _plan->twiddleVector.data() + step.rootIndex;
+			// On the stack, so that steps can run in parallel
+			complex sums[raderMinimum/2], diffs[raderMinimum/2];
+
+			for (size_t outerRepeat = 0; outerRepeat < step.outerRepeats; ++outerRepeat) {
+				RandomAccessIterator data = origData + from;
+				
+				const complex *twiddles = _plan->twiddleVector.data() + step.twiddleIndex + from;
+				for (size_t repeat = from; repeat < to; ++repeat) {
+					// Inputs i and (factor - i) have conjugate roots, so we pair them up
+					complex first = data[0], sum = first;
+					for (size_t i = 1; i <= halfFactor; ++i) {
+						complex a = loadTwiddled<inverse, dif, Access>(data, i*stride, twiddles, (i - 1)*stride);
+						complex b = loadTwiddled<inverse, dif, Access>(data, (factor - i)*stride, twiddles, (factor - i - 1)*stride);
+						sums[i - 1] = a + b;
+						diffs[i - 1] = a - b;
+						sum += sums[i - 1];
+					}
+					data[0] = sum;
+
+					for (size_t f = 1; f <= halfFactor; ++f) {
+						complex realSum = first, imagSum = 0;
+						size_t rootIndex = 0;
+						for (size_t i = 0; i < halfFactor; ++i) {
+							rootIndex += f;
+							if (rootIndex >= factor) rootIndex -= factor;
+							realSum += sums[i]*roots[rootIndex].real();
+							imagSum -= diffs[i]*roots[rootIndex].imag();
+						}
+						storeTwiddled<inverse, dif, Access>(data, f*stride, perf::complexAddI<!inverse>(realSum, imagSum), twiddles, (f - 1)*stride);
+						storeTwiddled<inverse, dif, Access>(data, (factor - f)*stride, perf::complexAddI<inverse>(realSum, imagSum), twiddles, (factor - f - 1)*stride);
+					}
+					++data;
+					++twiddles;
+				}
+				origData += factor*stride;
+			}
+		}
+
+		template<bool inverse, bool dif, typename RandomAccessIterator>
+		void fftStepRader(RandomAccessIterator origData, const Step &step, size_t from, size_t to) {
+			using Access = perf::ScalarAccess<V>;
+			const typename Plan::Rader &rader = _plan->raders[step.raderIndex];
+			Convolution &convolution = raderConvolutions[step.raderIndex];
+			const size_t factor = step.factor, stride = step.innerRepeats;
+			const size_t convolutionSize = rader.convolution.size();
+			complex *buffer = convolution.buffer.data();
+
+			for (size_t outerRepeat = 0; outerRepeat < step.outerRepeats; ++outerRepeat) {
+				RandomAccessIterator data = origData + from;
+
+				const complex *twiddles = _plan->twiddleVector.data() + step.twiddleIndex + from;
+				for (size_t repeat = from; repeat < to; ++repeat) {
+					complex first = data[0], sum = first;
+					for (size_t q = 0; q < factor - 1; ++q) {
+						size_t i = rader.inputIndices[q];
+						complex value = loadTwiddled<inverse, dif, Access>(data, i*stride, twiddles, (i - 1)*stride);
+						buffer[q] = value;
+						sum += value;
+					}
+					for (size_t q = factor - 1; q < convolutionSize; ++q) {
+						buffer[q] = 0;
+					}
+
+					// The inverse uses the conjugate roots
+					convolution.template run<inverse>(rader.convolution);
+
+					data[0] = sum;
+					for (size_t q = 0; q < factor - 1; ++q) {
+						size_t i = rader.outputIndices[q];
+						storeTwiddled<inverse, dif, Access>(data, i*stride, first + buffer[q], twiddles, (i - 1)*stride);
+					}
+					++data;
+					++twiddles;
+				}
+				origData += factor*stride;
+			}
+		}
+
+		// Each kernel computes butterflies [from, to), where the twiddles for input (or output, for DIF) f are at twiddles[(f - 1)*stride + index]
+		template<bool inverse, bool dif>
+		struct Kernel2 {
+			template<class Access, typename RandomAccessIterator>
+			static void run(RandomAccessIterator data, const complex * SIGNALSMITH_RESTRICT twiddles, size_t stride, size_t from, size_t to) {
+				using Value = typename Access::Value;
+				for (size_t i = from; i < to; i += Access::width) {
+					Value A = Access::load(data, i);
+					Value B = loadTwiddled<inverse, dif, Access>(data, i + stride, twiddles, i);
+
+					Access::store(data, i, A + B);
+					storeTwiddled<inverse, dif, Access>(data, i + stride, A - B, twiddles, i);
+				}
+			}
+		};
+
+		// Small DFTs for the odd radices, from x[0..n) into y[0..n)
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dft3(const Value *x, Value *y) {
+			constexpr complex factor3 = {-0.5, inverse ? 0.8660254037844386 : -0.8660254037844386};
+			Value realSum = x[0] + (x[1] + x[2])*factor3.real();
+			Value imagSum = (x[1] - x[2])*factor3.imag();
+			y[0] = x[0] + x[1] + x[2];
+			y[1] = perf::complexAddI<false>(realSum, imagSum);
+			y[2] = perf::complexAddI<true>(realSum, imagSum);
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dft5(const Value *x, Value *y) {
+			// Winograd's radix-5, which needs 5 real-valued multiplications
+			constexpr V cosSum = -1.25; // (cos(2pi/5) + cos(4pi/5))/2 - 1
+			constexpr V cosDiff = 0.5590169943749475; // (cos(2pi/5) - cos(4pi/5))/2
+			constexpr V sin2 = 0.5877852522924732; // sin(4pi/5)
+			constexpr V sinDiff = 0.3632712640026803; // sin(2pi/5) - sin(4pi/5)
+			constexpr V sinSum = 1.5388417685876268; // sin(2pi/5) + sin(4pi/5)
+			Value sumBE = x[1] + x[4], sumCD = x[2] + x[3];
+			Value diffBE = x[1] - x[4], diffCD = x[2] - x[3];
+			Value sum = sumBE + sumCD;
+
+			Value sum0 = x[0] + sum;
+			Value realCommon = sum0 + sum*cosSum;
+			Value realDiff = (sumBE - sumCD)*cosDiff;
+			Value real1 = realCommon + realDiff, real2 = realCommon - realDiff;
+
+			Value imagCommon = (diffBE + diffCD)*sin2;
+			Value imag1 = imagCommon + diffBE*sinDiff;
+			Value imag2 = imagCommon - diffCD*sinSum;
+
+			y[0] = sum0;
+			y[1] = perf::complexAddI<!inverse>(real1, imag1);
+			y[2] = perf::complexAddI<!inverse>(real2, imag2);
+			y[3] = perf::complexAddI<inverse>(real2, imag2);
+			y[4] = perf::complexAddI<inverse>(real1, imag1);
+		}
+
+		template<bool inverse, bool dif>
+		struct Kernel3 {
+			template<class Access, typename RandomAccessIterator>
+			static void run(RandomAccessIterator data, const complex * SIGNALSMITH_RESTRICT twiddles, size_t stride, size_t from, size_t to) {
+				using Value = typename Access::Value;
+				for (size_t i = from; i < to; i += Access::width) {
+					Value x[3], y[3];
+					x[0] = Access::load(data, i);
+					x[1] = loadTwiddled<inverse, dif, Access>(data, i + stride, twiddles, i);
+					x[2] = loadTwiddled<inverse, dif, Access>(data, i + stride*2, twiddles, i + stride);
+					dft3<inverse>(x, y);
+					Access::store(data, i, y[0]);
+					storeTwiddled<inverse, dif, Access>(data, i + stride, y[1], twiddles, i);
+					storeTwiddled<inverse, dif, Access>(data, i + stride*2, y[2], twiddles, i + stride);
+				}
+			}
+		};
+
+		template<bool inverse, bool dif>
+		struct Kernel4 {
+			template<class Access, typename RandomAccessIterator>
+			static void run(RandomAccessIterator data, const complex * SIGNALSMITH_RESTRICT twiddles, size_t stride, size_t from, size_t to) {
+				using Value = typename Access::Value;
+				for (size_t i = from; i < to; i += Access::width) {
+					if (dif) {
+						// Natural-order inputs, with the outputs in bit-reversed order
+						Value A = Access::load(data, i);
+						Value B = Access::load(data, i + stride);
+						Value C = Access::load(data, i + stride*2);
+						Value D = Access::load(data, i + stride*3);
+
+						Value sumAC = A + C, sumBD = B + D;
+						Value diffAC = A - C, diffBD = B - D;
+
+						Access::store(data, i, sumAC + sumBD);
+						storeTwiddled<inverse, dif, Access>(data, i + stride, sumAC - sumBD, twiddles, i + stride);
+						storeTwiddled<inverse, dif, Access>(data, i + stride*2, perf::complexAddI<!inverse>(diffAC, diffBD), twiddles, i);
+						storeTwiddled<inverse, dif, Access>(data, i + stride*3, perf::complexAddI<inverse>(diffAC, diffBD), twiddles, i + stride*2);
+					} else {
+						// The inputs are in bit-reversed order, because this step is two radix-2 factors combined
+						Value A = Access::load(data, i);
+						Value C = loadTwiddled<inverse, dif, Access>(data, i + stride, twiddles, i + stride);
+						Value B = loadTwiddled<inverse, dif, Access>(data, i + stride*2, twiddles, i);
+						Value D = loadTwiddled<inverse, dif, Access>(data, i + stride*3, twiddles, i + stride*2);
+
+						Value sumAC = A + C, sumBD = B + D;
+						Value diffAC = A - C, diffBD = B - D;
+
+						Access::store(data, i, sumAC + sumBD);
+						Access::store(data, i + stride, perf::complexAddI<!inverse>(diffAC, diffBD));
+						Access::store(data, i + stride*2, sumAC - sumBD);
+						Access::store(data, i + stride*3, perf::complexAddI<inverse>(diffAC, diffBD));
+					}
+				}
+			}
+		};
+
+		template<bool inverse, bool dif>
+		struct Kernel5 {
+			template<class Access, typename RandomAccessIterator>
+			static void run(RandomAccessIterator data, const complex * SIGNALSMITH_RESTRICT twiddles, size_t stride, size_t from, size_t to) {
+				using Value = typename Access::Value;
+				for (size_t i = from; i < to; i += Access::width) {
+					Value x[5], y[5];
+					x[0] = Access::load(data, i);
+					for (size_t k = 1; k < 5; ++k) {
+						x[k] = loadTwiddled<inverse, dif, Access>(data, i + stride*k, twiddles, i + stride*(k - 1));
+					}
+					dft5<inverse>(x, y);
+					Access::store(data, i, y[0]);
+					for (size_t k = 1; k < 5; ++k) {
+						storeTwiddled<inverse, dif, Access>(data, i + stride*k, y[k], twiddles, i + stride*(k - 1));
+					}
+				}
+			}
+		};
+
+		// Small DFTs for the larger power-of-2 kernels, from x[0], x[xStride], ... into y[0..n) (both in natural order).
+		// The internal twiddles are all 8th or 16th roots of unity, so they're done with additions and a few real multiplications.
+		template<bool inverse, size_t xStride, class Value>
+		static SIGNALSMITH_INLINE void dft4(const Value *x, Value *y) {
+			Value sumAC = x[0] + x[2*xStride], sumBD = x[xStride] + x[3*xStride];
+			Value diffAC = x[0] - x[2*xStride], diffBD = x[xStride] - x[3*xStride];
+			y[0] = sumAC + sumBD;
+			y[1] = perf::complexAddI<!inverse>(diffAC, diffBD);
+			y[2] = sumAC - sumBD;
+			y[3] = perf::complexAddI<inverse>(diffAC, diffBD);
+		}
+		template<bool inverse, size_t xStride, class Value>
+		static SIGNALSMITH_INLINE void dft8(const Value *x, Value *y) {
+			constexpr V sqrtHalf = 0.7071067811865476;
+			Value even[4], odd[4];
+			dft4<inverse, 2*xStride>(x, even);
+			dft4<inverse, 2*xStride>(x + xStride, odd);
+			// Odd half rotated by W8^k: W8 = (1 - i)/sqrt(2), W8^2 = -i, W8^3 = -(1 + i)/sqrt(2)
+			Value odd1 = perf::complexAddI<!inverse>(odd[1], odd[1])*sqrtHalf;
+			Value odd3 = perf::complexAddI<inverse>(odd[3], odd[3])*sqrtHalf;
+			y[0] = even[0] + odd[0];
+			y[4] = even[0] - odd[0];
+			y[1] = even[1] + odd1;
+			y[5] = even[1] - odd1;
+			y[2] = perf::complexAddI<!inverse>(even[2], odd[2]);
+			y[6] = perf::complexAddI<inverse>(even[2], odd[2]);
+			y[3] = even[3] - odd3;
+			y[7] = even[3] + odd3;
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dft16(const Value *x, Value *y) {
+			constexpr V sqrtHalf = 0.7071067811865476;
+			constexpr V cos1 = 0.9238795325112867, sin1 = 0.3826834323650898; // cos(pi/8), sin(pi/8)
+			Value even[8], odd[8];
+			dft8<inverse, 2>(x, even);
+			dft8<inverse, 2>(x + 1, odd);
+			// W16^k for k = 1, 3, 5, 7 are (cos1 - i*sin1), (sin1 - i*cos1), -(sin1 + i*cos1), -(cos1 + i*sin1)
+			Value odd1 = perf::complexAddI<!inverse>(odd[1]*cos1, odd[1]*sin1);
+			Value odd2 = perf::complexAddI<!inverse>(odd[2], odd[2])*sqrtHalf;
+			Value odd3 = perf::complexAddI<!inverse>(odd[3]*sin1, odd[3]*cos1);
+			Value odd5 = perf::complexAddI<inverse>(odd[5]*sin1, odd[5]*cos1);
+			Value odd6 = perf::complexAddI<inverse>(odd[6], odd[6])*sqrtHalf;
+			Value odd7 = perf::complexAddI<inverse>(odd[7]*cos1, odd[7]*sin1);
+			y[0] = even[0] + odd[0];
+			y[8] = even[0] - odd[0];
+			y[1] = even[1] + odd1;
+			y[9] = even[1] - odd1;
+			y[2] = even[2] + odd2;
+			y[10] = even[2] - odd2;
+			y[3] = even[3] + odd3;
+			y[11] = even[3] - odd3;
+			y[4] = perf::complexAddI<!inverse>(even[4], odd[4]);
+			y[12] = perf::complexAddI<inverse>(even[4], odd[4]);
+			y[5] = even[5] - odd5;
+			y[13] = even[5] + odd5;
+			y[6] = even[6] - odd6;
+			y[14] = even[6] + odd6;
+			y[7] = even[7] - odd7;
+			y[15] = even[7] + odd7;
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftPower2(const Value *x, Value *y, std::integral_constant<size_t, 1>) {
+			y[0] = x[0] + x[1];
+			y[1] = x[0] - x[1];
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftPower2(const Value *x, Value *y, std::integral_constant<size_t, 2>) {
+			dft4<inverse, 1>(x, y);
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftPower2(const Value *x, Value *y, std::integral_constant<size_t, 3>) {
+			dft8<inverse, 1>(x, y);
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftPower2(const Value *x, Value *y, std::integral_constant<size_t, 4>) {
+			dft16<inverse>(x, y);
+		}
+		template<size_t bits>
+		static constexpr size_t bitReverse(size_t index) {
+			return bits ? ((index&1) << (bits - 1))|bitReverse<(bits ? bits - 1 : 0)>(index >> 1) : 0;
+		}
+
+		// Radix-8 and radix-16 steps are 3 or 4 radix-2 factors combined, so (like radix-4) the DIT inputs and DIF outputs are in bit-reversed order
+		template<bool inverse, bool dif, size_t bits>
+		struct KernelPower2 {
+			static constexpr size_t radix = size_t(1) << bits;
+
+			template<class Access, typename RandomAccessIterator>
+			static void run(RandomAccessIterator data, const complex * SIGNALSMITH_RESTRICT twiddles, size_t stride, size_t from, size_t to) {
+				using Value = typename Access::Value;
+				for (size_t i = from; i < to; i += Access::width) {
+					Value x[radix], y[radix];
+					if (dif) {
+						for (size_t k = 0; k < radix; ++k) x[k] = Access::load(data, i + k*stride);
+					} else {
+						x[0] = Access::load(data, i);
+						for (size_t k = 1; k < radix; ++k) {
+							x[k] = loadTwiddled<inverse, dif, Access>(data, i + bitReverse<bits>(k)*stride, twiddles, i + (k - 1)*stride);
+						}
+					}
+					dftPower2<inverse>(x, y, std::integral_constant<size_t, bits>());
+					if (dif) {
+						Access::store(data, i, y[0]);
+						for (size_t k = 1; k < radix; ++k) {
+							storeTwiddled<inverse, dif, Access>(data, i + bitReverse<bits>(k)*stride, y[k], twiddles, i + (k - 1)*stride);
+						}
+					} else {
+						for (size_t k = 0; k < radix; ++k) Access::store(data, i + k*stride, y[k]);
+					}
+				}
+			}
+		};
+		template<bool inverse, bool dif>
+		using Kernel8 = KernelPower2<inverse, dif, 3>;
+		template<bool inverse, bool dif>
+		using Kernel16 = KernelPower2<inverse, dif, 4>;
+
+		// Split-radix combines an L/2-point DFT (of the even inputs) with two L/4-point DFTs (inputs 4n + 1 and 4n + 3).  With bit-reversed inputs, these are three contiguous blocks: [0, L/2), [L/2, 3L/4) and [3L/4, L).
+		// Each kernel is one "L-shaped" butterfly, where `stride` is L/4 and the twiddles are W^k and then W^3k
+		template<bool inverse, bool dif>
+		struct KernelSplitRadix {
+			template<class Access, typename RandomAccessIterator>
+			static void run(RandomAccessIterator data, const complex * SIGNALSMITH_RESTRICT twiddles, size_t stride, size_t from, size_t to) {
+				using Value = typename Access::Value;
+				for (size_t i = from; i < to; i += Access::width) {
+					if (dif) {
+						Value A = Access::load(data, i);
+						Value B = Access::load(data, i + stride);
+						Value C = Access::load(data, i + stride*2);
+						Value D = Access::load(data, i + stride*3);
+						Value diffAC = A - C, diffBD = B - D;
+
+						Access::store(data, i, A + C);
+						Access::store(data, i + stride, B + D);
+						Access::store(data, i + stride*2, perf::complexMul<inverse>(perf::complexAddI<!inverse>(diffAC, diffBD), Access::twiddle(twiddles, i)));
+						Access::store(data, i + stride*3, perf::complexMul<inverse>(perf::complexAddI<inverse>(diffAC, diffBD), Access::twiddle(twiddles, i + stride)));
+					} else {
+						Value U0 = Access::load(data, i);
+						Value U1 = Access::load(data, i + stride);
+						Value Z1 = perf::complexMul<inverse>(Access::load(data, i + stride*2), Access::twiddle(twiddles, i));
+						Value Z3 = perf::complexMul<inverse>(Access::load(data, i + stride*3), Access::twiddle(twiddles, i + stride));
+						Value sum = Z1 + Z3, diff = Z1 - Z3;
+
+						Access::store(data, i, U0 + sum);
+						Access::store(data, i + stride, perf::complexAddI<!inverse>(U1, diff));
+						Access::store(data, i + stride*2, U0 - sum);
+						Access::store(data, i + stride*3, perf::complexAddI<inverse>(U1, diff));
+					}
+				}
+			}
+		};
+		// Small blocks are a single DFT (with bit-reversed inputs, or outputs for DIF)
+		template<bool inverse, bool dif, size_t bits, typename RandomAccessIterator>
+		static void splitRadixBlock(RandomAccessIterator data) {
+			constexpr size_t length = size_t(1) << bits;
+			complex x[length], y[length];
+			for (size_t k = 0; k < length; ++k) x[k] = data[dif ? k : bitReverse<bits>(k)];
+			dftPower2<inverse>(x, y, std::integral_constant<size_t, bits>());
+			for (size_t k = 0; k < length; ++k) data[dif ? bitReverse<bits>(k) : k] = y[k];
+		}
+		// Depth-first, so the smaller blocks are still in cache
+		template<bool inverse, bool dif, typename RandomAccessIterator>
+		void runSplitRadix(RandomAccessIterator data, size_t length) {
+			if (length <= 16) {
+				if (length == 16) return splitRadixBlock<inverse, dif, 4>(data);
+				if (length == 8) return splitRadixBlock<inverse, dif, 3>(data);
+				if (length == 4) return splitRadixBlock<inverse, dif, 2>(data);
+				if (length == 2) return splitRadixBlock<inverse, dif, 1>(data);
+				return;
+			}
+			using Butterflies = perf::Butterflies<KernelSplitRadix<inverse, dif>, V, RandomAccessIterator>;
+			const size_t quarter = length/4;
+			const complex *twiddles = _plan->splitRadixTwiddles.data() + length/2;
+			if (dif) Butterflies::run(data, twiddles, quarter, quarter);
+			runSplitRadix<inverse, dif>(data, length/2);
+			runSplitRadix<inverse, dif>(data + quarter*2, quarter);
+			runSplitRadix<inverse, dif>(data + quarter*3, quarter);
+			if (!dif) Butterflies::run(data, twiddles, quarter, quarter);
+		}
+
+		// Natural-order DFTs for each Stockham radix
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftRadix(const Value *x, Value *y, std::integral_constant<size_t, 2>) {
+			dftPower2<inverse>(x, y, std::integral_constant<size_t, 1>());
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftRadix(const Value *x, Value *y, std::integral_constant<size_t, 3>) {
+			dft3<inverse>(x, y);
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftRadix(const Value *x, Value *y, std::integral_constant<size_t, 4>) {
+			dft4<inverse, 1>(x, y);
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftRadix(const Value *x, Value *y, std::integral_constant<size_t, 5>) {
+			dft5<inverse>(x, y);
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftRadix(const Value *x, Value *y, std::integral_constant<size_t, 8>) {
+			dft8<inverse, 1>(x, y);
+		}
+		template<bool inverse, class Value>
+		static SIGNALSMITH_INLINE void dftRadix(const Value *x, Value *y, std::integral_constant<size_t, 16>) {
+			dft16<inverse>(x, y);
+		}
+
+		// One Stockham butterfly for each index in [from, to): the inputs are `inputStride` apart, and the outputs `outputStride` apart.
+		// The twiddle for output k is at `twiddles[(k - 1)*twiddleStride]`, the same for all the indices.
+		template<bool inverse, size_t radix>
+		struct KernelStockham {
+			template<class Access, typename InputIterator, typename OutputIterator>
+			static void run(InputIterator input, size_t inputStride, OutputIterator output, size_t outputStride, const complex * SIGNALSMITH_RESTRICT twiddles, size_t twiddleStride, size_t from, size_t to) {
+				using Value = typename Access::Value;
+				for (size_t i = from; i < to; i += Access::width) {
+					Value x[radix], y[radix];
+					for (size_t j = 0; j < radix; ++j) x[j] = Access::load(input, i + j*inputStride);
+					dftRadix<inverse>(x, y, std::integral_constant<size_t, radix>());
+					Access::store(output, i, y[0]);
+					for (size_t k = 1; k < radix; ++k) {
+						Access::store(output, i + k*outputStride, perf::complexMul<inverse>(y[k], Access::twiddle(twiddles, (k - 1)*twiddleStride)));
+					}
+				}
+			}
+		};
+		// The SIMD lanes are along the stride, so each group's twiddles are copied into a small table to load them for all the lanes
+		template<bool inverse, size_t radix, typename InputIterator, typename OutputIterator>
+		void stockhamStage(InputIterator input, OutputIterator output, const typename Plan::StockhamStage &stage) {
+			using Kernel = KernelStockham<inverse, radix>;
+			using Access = typename perf::WideAccess<V, InputIterator, OutputIterator>::type;
+			using ScalarAccess = perf::ScalarAccess<V>;
+			constexpr size_t width = Access::width;
+			const size_t groups = stage.groups, stride = stage.stride;
+			const complex *twiddles = _plan->twiddleVector.data() + stage.twiddleIndex;
+			if (stride < width) {
+				for (size_t p = 0; p < groups; ++p) {
+					Kernel::template run<ScalarAccess>(input + p*stride, groups*stride, output + p*radix*stride, stride, twiddles + p, groups, 0, stride);
+				}
+				return;
+			}
+			const size_t vectorEnd = stride - stride%width;
+			complex groupTwiddles[(radix - 1)*width];
+			for (size_t p = 0; p < groups; ++p) {
+				for (size_t k = 1; k < radix; ++k) {
+					for (size_t lane = 0; lane < width; ++lane) groupTwiddles[(k - 1)*width + lane] = twiddles[(k - 1)*groups + p];
+				}
+				Kernel::template run<Access>(input + p*stride, groups*stride, output + p*radix*stride, stride, groupTwiddles, width, 0, vectorEnd);
+				Kernel::template run<ScalarAccess>(input + p*stride, groups*stride, output + p*radix*stride, stride, groupTwiddles, width, vectorEnd, stride);
+			}
+		}
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void stockhamStage(InputIterator input, OutputIterator output, const typename Plan::StockhamStage &stage) {
+			switch (stage.radix) {
+				case 2: return stockhamStage<inverse, 2>(input, output, stage);
+				case 3: return stockhamStage<inverse, 3>(input, output, stage);
+				case 4: return stockhamStage<inverse, 4>(input, output, stage);
+				case 5: return stockhamStage<inverse, 5>(input, output, stage);
+				case 8: return stockhamStage<inverse, 8>(input, output, stage);
+				case 16: return stockhamStage<inverse, 16>(input, output, stage);
+			}
+		}
+		// Alternates between the output and `stockhamBuffer`, starting with whichever one leaves the result in the output
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void runStockham(InputIterator input, OutputIterator data) {
+			const auto &stages = _plan->stockhamStages;
+			const size_t stageCount = stages.size();
+			auto contiguousInput = contiguous(input);
+			auto contiguousData = contiguous(data);
+			complex *buffer = stockhamBuffer.data();
+			bool inPlace = sameData(contiguousInput, contiguousData);
+			if (!stageCount) {
+				if (!inPlace) for (size_t i = 0; i < _size; ++i) data[i] = input[i];
+				return;
+			}
+			if (inPlace && stageCount%2) {
+				// The first stage has to write to the output, so it reads a copy
+				for (size_t i = 0; i < _size; ++i) buffer[i] = contiguousData[i];
+			}
+			for (size_t s = 0; s < stageCount; ++s) {
+				bool toData = (stageCount - s)%2;
+				if (s == 0 && !inPlace) {
+					if (toData) {
+						stockhamStage<inverse>(contiguousInput, contiguousData, stages[s]);
+					} else {
+						stockhamStage<inverse>(contiguousInput, buffer, stages[s]);
+					}
+				} else if (toData) {
+					stockhamStage<inverse>((const complex *)buffer, contiguousData, stages[s]);
+				} else {
+					stockhamStage<inverse>(contiguousData, buffer, stages[s]);
+				}
+			}
+		}
+
+		template<class Kernel, typename RandomAccessIterator>
+		void fftStepKernel(RandomAccessIterator origData, const Step &step, size_t from, size_t to) {
+			const size_t stride = step.innerRepeats;
+			// Offsetting both pointers means the kernel computes butterflies [from, to)
+			const complex *twiddles = _plan->twiddleVector.data() + step.twiddleIndex + from;
+			perf::ButterflyRepeats<Kernel, V, RandomAccessIterator>::run(origData + from, twiddles, stride, to - from, step.outerRepeats, step.factor*stride);
+		}
+
+		// Contiguous data is passed on as a pointer, so that the SIMD kernels can be used
+		template<typename RandomAccessIterator>
+		static RandomAccessIterator contiguous(RandomAccessIterator iterator) {
+			return iterator;
+		}
+		static complex * contiguous(typename std::vector<complex>::iterator iterator) {
+			return &*iterator;
+		}
+		static const complex * contiguous(typename std::vector<complex>::const_iterator iterator) {
+			return &*iterator;
+		}
+
+		// Detects in-place use (but not partial overlap)
+		template<typename InputIterator, typename OutputIterator>
+		static bool sameData(InputIterator, OutputIterator) {
+			return false;
+		}
+		template<typename RandomAccessIterator>
+		static bool sameData(RandomAccessIterator input, RandomAccessIterator data) {
+			return input == data;
+		}
+		template<typename T>
+		static bool sameData(const T *input, T *data) {
+			return input == data;
+		}
+		
+		// The first step's twiddles are all 1, so (out-of-place) it gathers its inputs straight from the input, instead of permuting first
+		template<bool inverse, size_t radix, typename InputIterator, typename OutputIterator>
+		void runFirstStep(InputIterator input, OutputIterator data) {
+			const size_t inputStride = _size/radix;
+			_plan->forEachFirstStep(0, inputStride, [&](size_t from, size_t to) {
+				complex x[radix], y[radix];
+				for (size_t k = 0; k < radix; ++k) x[k] = input[to + k*inputStride];
+				dftRadix<inverse>(x, y, std::integral_constant<size_t, radix>());
+				for (size_t k = 0; k < radix; ++k) data[from*radix + k] = y[k];
+			});
+		}
+		// Contiguous data does several butterflies at once, one in each SIMD lane (gathered and scattered like `fftBatch()`)
+		template<bool inverse, size_t radix>
+		void runFirstStep(const complex *input, complex *data) {
+			runFirstStepLanes<inverse, radix>(std::integral_constant<bool, (batchLanes > 1)>(), input, data);
+		}
+		template<bool inverse, size_t radix>
+		void runFirstStep(complex *input, complex *data) {
+			runFirstStep<inverse, radix>((const complex *)input, data);
+		}
+		template<bool inverse, size_t radix>
+		void runFirstStepLanes(std::false_type, const complex *input, complex *data) {
+			runFirstStep<inverse, radix, const complex *, complex *>(input, data);
+		}
+		template<bool inverse, size_t radix>
+		void runFirstStepLanes(std::true_type, const complex *input, complex *data) {
+			using Value = typename BatchAccess::Value;
+			const size_t inputStride = _size/radix;
+			const complex *inputs[batchLanes];
+			complex *outputs[batchLanes];
+			auto butterflies = [&]() {
+				Value x[radix], y[radix];
+				for (size_t k = 0; k < radix; ++k) x[k] = BatchAccess::gather(inputs, k*inputStride);
+				dftRadix<inverse>(x, y, std::integral_constant<size_t, radix>());
+				for (size_t k = 0; k < radix; ++k) BatchAccess::scatter(y[k], outputs, k);
+			};
+			size_t lane = 0;
+			_plan->forEachFirstStep(0, inputStride, [&](size_t from, size_t to) {
+				inputs[lane] = input + to;
+				outputs[lane] = data + from*radix;
+				if (++lane < batchLanes) return;
+				lane = 0;
+				butterflies();
+			});
+			// Any left over (if the number of butterflies isn't a multiple of the lanes) fill the spare lanes by repeating the first one.
+			// This keeps all the arithmetic in SIMD, so the results match the other steps (and `FixedFFT`) exactly, even where the compiler would fuse the scalar version into FMAs.
+			if (lane) {
+				for (size_t l = lane; l < batchLanes; ++l) {
+					inputs[l] = inputs[0];
+					outputs[l] = outputs[0];
+				}
+				butterflies();
+			}
+		}
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void runFirstStep(InputIterator input, OutputIterator data) {
+			switch (_plan->firstRadix) {
+				case 2: return runFirstStep<inverse, 2>(input, data);
+				case 3: return runFirstStep<inverse, 3>(input, data);
+				case 4: return runFirstStep<inverse, 4>(input, data);
+				case 5: return runFirstStep<inverse, 5>(input, data);
+				case 8: return runFirstStep<inverse, 8>(input, data);
+				case 16: return runFirstStep<inverse, 16>(input, data);
+			}
+		}
+
+		template<typename InputIterator, typename OutputIterator>
+		void permute(InputIterator input, OutputIterator data) {
+			_plan->forEachPermutation(0, _size, [&](size_t from, size_t to) {
+				data[from] = input[to];
+			});
+		}
+		template<typename RandomAccessIterator, typename Index>
+		void permuteCycles(RandomAccessIterator data, const typename Plan::template Cycles<Index> &cycles, size_t fromCycle, size_t toCycle) {
+			const Index *indices = cycles.indices.data();
+			size_t start = fromCycle ? cycles.ends[fromCycle - 1] : 0;
+			for (size_t cycle = fromCycle; cycle < toCycle; ++cycle) {
+				size_t end = cycles.ends[cycle];
+				complex first = data[indices[start]];
+				for (size_t i = start; i + 1 < end; ++i) {
+					data[indices[i]] = data[indices[i + 1]];
+				}
+				data[indices[end - 1]] = first;
+				start = end;
+			}
+		}
+		template<typename RandomAccessIterator>
+		void permuteInPlace(RandomAccessIterator data) {
+			_plan->setCycles();
+			permuteCycles(data, _plan->cycles32, 0, _plan->cycles32.ends.size());
+			permuteCycles(data, _plan->cycles64, 0, _plan->cycles64.ends.size());
+		}
+
+		// Runs butterflies [from, to) of each repeat
+		template<bool inverse, bool dif, typename RandomAccessIterator>
+		void runStep(RandomAccessIterator data, const Step &step, size_t from, size_t to) {
+			switch (step.type) {
+				case StepType::generic:
+					fftStepGeneric<inverse, dif>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::step2:
+					fftStepKernel<Kernel2<inverse, dif>>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::step3:
+					fftStepKernel<Kernel3<inverse, dif>>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::step4:
+					fftStepKernel<Kernel4<inverse, dif>>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::step5:
+					fftStepKernel<Kernel5<inverse, dif>>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::step8:
+					fftStepKernel<Kernel8<inverse, dif>>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::step16:
+					fftStepKernel<Kernel16<inverse, dif>>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::rader:
+					fftStepRader<inverse, dif>(data + step.startIndex, step, from, to);
+					break;
+				case StepType::split:
+					break;
+			}
+		}
+		template<bool inverse, bool dif, typename RandomAccessIterator>
+		void runStep(RandomAccessIterator data, const Step &step) {
+			runStep<inverse, dif>(data, step, 0, step.innerRepeats);
+		}
+		// `firstDone` skips the first step (which is all the steps with a stride of 1) if it was fused with the permutation
+		template<bool inverse, typename RandomAccessIterator>
+		void runSteps(RandomAccessIterator data, bool firstDone=false) {
+			if (_plan->useSplitRadix) return runSplitRadix<inverse, false>(data, _size);
+			if (useThreads()) return runStepsThreaded<inverse, false>(data);
+			for (const Step &step : _plan->steps) {
+				if (firstDone && step.innerRepeats == 1 && step.type != StepType::split) continue;
+				runStep<inverse, false>(data, step);
+			}
+		}
+		// Decimation-in-frequency: takes natural-order input, and leaves the result in the permuted order
+		template<bool inverse, typename RandomAccessIterator>
+		void runStepsTransposed(RandomAccessIterator data) {
+			if (_plan->useSplitRadix) return runSplitRadix<inverse, true>(data, _size);
+			if (useThreads()) return runStepsThreaded<inverse, true>(data);
+			for (size_t i = _plan->steps.size(); i > 0; --i) {
+				runStep<inverse, true>(data, _plan->steps[i - 1]);
+			}
+		}
+
+		FFTExecutor *executor = nullptr;
+		bool useThreads() const {
+			return executor && (_plan->useSixStep || !_plan->threadPhases.empty()) && executor->concurrency() > 1;
+		}
+
+		template<bool inverse, bool dif, typename RandomAccessIterator>
+		void runThreadPhase(RandomAccessIterator data, const ThreadPhase &phase) {
+			if (phase.whole) {
+				executor->parallelFor(phase.copies, [&](size_t copy) {
+					RandomAccessIterator copyData = data + copy*phase.copyStride;
+					for (size_t i = phase.begin; i < phase.end; ++i) {
+						runStep<inverse, dif>(copyData, _plan->steps[dif ? (phase.end + phase.begin - 1 - i) : i]);
+					}
+				});
+				return;
+			}
+			Step step = _plan->steps[phase.begin];
+			// The copies are contiguous, so they're just more outer repeats
+			step.outerRepeats *= phase.copies;
+			const size_t stride = step.innerRepeats, outerStride = step.factor*stride;
+			const size_t chunks = executor->concurrency()*2;
+			if (step.outerRepeats >= chunks) {
+				executor->parallelFor(chunks, [&](size_t chunk) {
+					size_t from = step.outerRepeats*chunk/chunks, to = step.outerRepeats*(chunk + 1)/chunks;
+					Step part = step;
+					part.startIndex += from*outerStride;
+					part.outerRepeats = to - from;
+					runStep<inverse, dif>(data, part);
+				});
+			} else {
+				// Split each repeat's butterflies into chunks, which are a multiple of 4 to keep the SIMD loops whole
+				const size_t innerChunks = (chunks + step.outerRepeats - 1)/step.outerRepeats;
+				executor->parallelFor(step.outerRepeats*innerChunks, [&](size_t index) {
+					size_t chunk = index%innerChunks;
+					size_t from = (stride*chunk/innerChunks)&~size_t(3);
+					size_t to = (chunk + 1 == innerChunks) ? stride : (stride*(chunk + 1)/innerChunks)&~size_t(3);
+					Step part = step;
+					part.startIndex += (index/innerChunks)*outerStride;
+					part.outerRepeats = 1;
+					runStep<inverse, dif>(data, part, from, to);
+				});
+			}
+		}
+		template<bool inverse, bool dif, typename RandomAccessIterator>
+		void runStepsThreaded(RandomAccessIterator data) {
+			const size_t phaseCount = _plan->threadPhases.size();
+			for (size_t i = 0; i < phaseCount; ++i) {
+				runThreadPhase<inverse, dif>(data, _plan->threadPhases[dif ? (phaseCount - 1 - i) : i]);
+			}
+		}
+		template<typename InputIterator, typename OutputIterator>
+		void permuteThreaded(InputIterator input, OutputIterator data) {
+			const size_t chunks = executor->concurrency()*2;
+			executor->parallelFor(chunks, [&](size_t chunk) {
+				_plan->forEachPermutation(_size*chunk/chunks, _size*(chunk + 1)/chunks, [&](size_t from, size_t to) {
+					data[from] = input[to];
+				});
+			});
+		}
+		template<typename RandomAccessIterator>
+		void permuteInPlaceThreaded(RandomAccessIterator data) {
+			_plan->setCycles();
+			permuteCyclesThreaded(data, _plan->cycles32);
+			permuteCyclesThreaded(data, _plan->cycles64);
+		}
+		template<typename RandomAccessIterator, typename Index>
+		void permuteCyclesThreaded(RandomAccessIterator data, const typename Plan::template Cycles<Index> &cycles) {
+			// The cycles are independent, so they're shared out between the tasks
+			const size_t chunks = executor->concurrency()*2, cycleCount = cycles.ends.size();
+			if (!cycleCount) return;
+			executor->parallelFor(chunks, [&](size_t chunk) {
+				size_t fromCycle = cycleCount*chunk/chunks, toCycle = cycleCount*(chunk + 1)/chunks;
+				permuteCycles(data, cycles, fromCycle, toCycle);
+			});
+		}
+
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void runBluestein(InputIterator &&input, OutputIterator &&output) {
+			const size_t convolutionSize = _plan->bluesteinConvolution.size();
+			complex *buffer = bluesteinConvolution.buffer.data();
+			const complex *chirp = _plan->bluesteinChirp.data();
+			// The inverse uses the conjugate chirp
+			for (size_t i = 0; i < _size; ++i) {
+				buffer[i] = perf::complexMul<inverse>((complex)input[i], chirp[i]);
+			}
+			for (size_t i = _size; i < convolutionSize; ++i) {
+				buffer[i] = 0;
+			}
+			bluesteinConvolution.template run<inverse>(_plan->bluesteinConvolution);
+			for (size_t i = 0; i < _size; ++i) {
+				output[i] = perf::complexMul<inverse>(buffer[i], chirp[i]);
+			}
+		}
+
+		// Splits `count` items into contiguous ranges, one per task, and calls `fn(task, from, to)` for each
+		template<class Fn>
+		void sixStepTasks(size_t count, Fn &&fn) {
+			if (!useThreads()) return fn(0, 0, count);
+			// The buffer was sized by `setExecutor()`, so if the concurrency has grown since then we use fewer tasks instead of allocating
+			const size_t tasks = std::min(executor->concurrency(), sixStepWork.buffer.size()/_plan->sixStep.bufferSize());
+			executor->parallelFor(tasks, [&](size_t task) {
+				fn(task, count*task/tasks, count*(task + 1)/tasks);
+			});
+		}
+
+		// Multiplies the results for `column` by W^(column*k)
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void sixStepTwiddle(InputIterator input, OutputIterator output, size_t height, size_t column) {
+			const size_t rows = _plan->sixStep.rows;
+			const complex *twiddlesLow = _plan->sixStep.twiddlesLow.data(), *twiddlesHigh = _plan->sixStep.twiddlesHigh.data();
+			// Step through column*k = high*rows + low, without dividing
+			const size_t stepHigh = column/rows, stepLow = column%rows;
+			size_t high = 0, low = 0;
+			for (size_t k = 0; k < height; ++k) {
+				complex w = perf::complexMul<false>(twiddlesHigh[high], twiddlesLow[low]);
+				output[k] = perf::complexMul<inverse>((complex)input[k], w);
+				high += stepHigh;
+				low += stepLow;
+				if (low >= rows) {
+					low -= rows;
+					++high;
+				}
+			}
+		}
+
+		// FFTs down each column of a (height x width) matrix, one block of columns at a time, with optional six-step twiddles before or after.
+		// The results are written back to the same positions, or (for `transposeOutput`) as rows of a (width x height) matrix.
+		template<bool inverse, bool twiddleBefore, bool twiddleAfter, bool transposeOutput, typename InputIterator, typename OutputIterator>
+		void sixStepColumns(InputIterator input, OutputIterator output, size_t height, size_t width, FFT &columnFft) {
+			const size_t blocks = (width + sixStepBlock - 1)/sixStepBlock;
+			const size_t bufferStride = height + sixStepPadding;
+			constexpr size_t prefetchRows = 16, cacheLine = 64/sizeof(complex);
+			sixStepTasks(blocks, [&](size_t task, size_t fromBlock, size_t toBlock) {
+				complex *buffer = sixStepWork.buffer.data() + task*_plan->sixStep.bufferSize();
+				complex *batchData = buffer + sixStepBlock*bufferStride;
+				for (size_t block = fromBlock; block < toBlock; ++block) {
+					const size_t column0 = block*sixStepBlock, blockWidth = std::min<size_t>(width - column0, size_t(sixStepBlock));
+					for (size_t r = 0; r < height; ++r) {
+						// The rows are far apart, so the hardware prefetcher doesn't help
+						if (r + prefetchRows < height) {
+							for (size_t j = 0; j < blockWidth; j += cacheLine) {
+								perf::prefetch(contiguous(input + (column0 + j + (r + prefetchRows)*width)));
+							}
+						}
+						for (size_t j = 0; j < blockWidth; ++j) {
+							buffer[j*bufferStride + r] = input[column0 + j + r*width];
+						}
+					}
+					if (twiddleBefore) {
+						for (size_t j = 0; j < blockWidth; ++j) {
+							complex *column = buffer + j*bufferStride;
+							sixStepTwiddle<inverse>(column, column, height, column0 + j);
+						}
+					}
+					// The columns are transformed together, one in each SIMD lane (see `fftBatch()`)
+					columnFft.template runBatch<inverse>(std::integral_constant<bool, (batchLanes > 1)>(), buffer, buffer, blockWidth, bufferStride, batchData);
+					if (twiddleAfter) {
+						for (size_t j = 0; j < blockWidth; ++j) {
+							complex *column = buffer + j*bufferStride;
+							if (transposeOutput) {
+								sixStepTwiddle<inverse>(column, output + (column0 + j)*height, height, column0 + j);
+							} else {
+								sixStepTwiddle<inverse>(column, column, height, column0 + j);
+							}
+						}
+					} else if (transposeOutput) {
+						for (size_t j = 0; j < blockWidth; ++j) {
+							complex *column = buffer + j*bufferStride;
+							std::copy(column, column + height, output + (column0 + j)*height);
+						}
+					}
+					if (!transposeOutput) {
+						for (size_t r = 0; r < height; ++r) {
+							for (size_t j = 0; j < blockWidth; ++j) {
+								output[column0 + j + r*width] = buffer[j*bufferStride + r];
+							}
+						}
+					}
+				}
+			});
+		}
+
+		// FFTs along each row of the (rows x columns) matrix
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void sixStepRows(InputIterator input, OutputIterator output) {
+			const size_t columns = _plan->sixStep.columns;
+			sixStepTasks(_plan->sixStep.rows, [&](size_t task, size_t from, size_t to) {
+				complex *batchData = sixStepWork.buffer.data() + task*_plan->sixStep.bufferSize();
+				sixStepWork.rowFft->template runBatch<inverse>(std::integral_constant<bool, (batchLanes > 1)>(), contiguous(input + from*columns), contiguous(output + from*columns), to - from, columns, batchData);
+			});
+		}
+
+		// In-place transpose from (rows x columns) to (columns x rows)
+		template<typename RandomAccessIterator>
+		void sixStepTranspose(RandomAccessIterator data) {
+			const size_t rows = _plan->sixStep.rows, columns = _plan->sixStep.columns, blocks = columns/rows;
+			// Transpose each square (rows x rows) block, swapping pairs of tiles
+			const size_t tiles = (rows + sixStepTile - 1)/sixStepTile;
+			sixStepTasks(blocks*tiles, [&](size_t, size_t from, size_t to) {
+				for (size_t index = from; index < to; ++index) {
+					RandomAccessIterator blockData = data + (index/tiles)*rows;
+					const size_t tileI = index%tiles, i0 = tileI*sixStepTile, i1 = std::min<size_t>(i0 + sixStepTile, rows);
+					for (size_t j0 = i0; j0 < rows; j0 += sixStepTile) {
+						const size_t j1 = std::min<size_t>(j0 + sixStepTile, rows);
+						for (size_t i = i0; i < i1; ++i) {
+							for (size_t j = std::max(j0, i + 1); j < j1; ++j) {
+								complex a = blockData[i*columns + j];
+								blockData[i*columns + j] = blockData[j*columns + i];
+								blockData[j*columns + i] = a;
+							}
+						}
+					}
+				}
+			});
+			if (blocks == 1) return;
+			// Each row is now the transposed rows from all the blocks, so we shuffle the row-sized chunks into place
+			const size_t *indices = _plan->sixStep.chunkCycleIndices.data();
+			const size_t cycleCount = _plan->sixStep.chunkCycleEnds.size();
+			sixStepTasks(cycleCount, [&](size_t task, size_t fromCycle, size_t toCycle) {
+				complex *first = sixStepWork.buffer.data() + task*_plan->sixStep.bufferSize();
+				size_t start = fromCycle ? _plan->sixStep.chunkCycleEnds[fromCycle - 1] : 0;
+				for (size_t cycle = fromCycle; cycle < toCycle; ++cycle) {
+					size_t end = _plan->sixStep.chunkCycleEnds[cycle];
+					std::copy(data + indices[start]*rows, data + (indices[start] + 1)*rows, first);
+					for (size_t i = start; i + 1 < end; ++i) {
+						std::copy(data + indices[i + 1]*rows, data + (indices[i + 1] + 1)*rows, data + indices[i]*rows);
+					}
+					std::copy(first, first + rows, data + indices[end - 1]*rows);
+					start = end;
+				}
+			});
+		}
+
+		// Bin (k2 + rows*k1) ends up in row k2 and column k1, so the final transpose is skipped for the unordered spectrum
+		template<bool inverse, bool unordered, typename InputIterator, typename OutputIterator>
+		void runSixStep(InputIterator &&input, OutputIterator &&data) {
+			const size_t rows = _plan->sixStep.rows, columns = _plan->sixStep.columns;
+			auto contiguousData = contiguous(data);
+			if (unordered && inverse) {
+				// The forward steps (below) in reverse
+				sixStepRows<inverse>(input, contiguousData);
+				sixStepColumns<inverse, true, false, false>(contiguousData, contiguousData, rows, columns, *sixStepWork.columnFft);
+			} else if (unordered || sameData(contiguous(input), contiguousData)) {
+				sixStepColumns<inverse, false, true, false>(input, contiguousData, rows, columns, *sixStepWork.columnFft);
+				sixStepRows<inverse>(contiguousData, contiguousData);
+				if (!unordered) sixStepTranspose(contiguousData);
+			} else {
+				// The first pass writes its output transposed, so the second pass can work in-place without another transpose
+				sixStepColumns<inverse, false, true, true>(input, contiguousData, rows, columns, *sixStepWork.columnFft);
+				sixStepColumns<inverse, false, false, false>(contiguousData, contiguousData, columns, rows, *sixStepWork.rowFft);
+			}
+		}
+
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void run(InputIterator &&input, OutputIterator &&data) {
+			// Empty vectors have no element for `contiguous()` to point at
+			if (!_size) return;
+			if (_plan->useBluestein) return runBluestein<inverse>(input, data);
+			if (_plan->useSixStep) return runSixStep<inverse, false>(input, data);
+			if (_plan->useStockham) return runStockham<inverse>(input, data);
+
+			auto contiguousData = contiguous(data);
+			bool threads = useThreads();
+			if (sameData(contiguous(input), contiguousData)) {
+				if (threads) {
+					permuteInPlaceThreaded(contiguousData);
+				} else {
+					permuteInPlace(contiguousData);
+				}
+			} else if (threads) {
+				permuteThreaded(input, data);
+			} else if (_plan->firstRadix) {
+				runFirstStep<inverse>(contiguous(input), contiguousData);
+				return runSteps<inverse>(contiguousData, true);
+			} else {
+				permute(input, data);
+			}
+			runSteps<inverse>(contiguousData);
+		}
+
+		using BatchAccess = perf::BatchAccess<V>;
+		static constexpr size_t batchLanes = BatchAccess::lanes;
+		// Groups of channels are interleaved into this (see `perf::BatchAccess`), so each SIMD lane is a different channel.  It's several times the size, so it's only allocated on first use, or by `reserve()`.
+		Vector<complex> batchVector{allocator};
+
+		// Iterates through one channel of the batch data, for the steps which don't have a batch version
+		struct BatchChannelIterator {
+			V *pointer;
+
+			struct Reference {
+				V *pointer;
+
+				operator complex() const {
+					return {pointer[0], pointer[batchLanes]};
+				}
+				Reference & operator=(const complex &value) {
+					pointer[0] = value.real();
+					pointer[batchLanes] = value.imag();
+					return *this;
+				}
+			};
+
+			Reference operator[](size_t i) const {
+				return {pointer + i*2*batchLanes};
+			}
+			BatchChannelIterator operator+(size_t i) const {
+				return {pointer + i*2*batchLanes};
+			}
+			BatchChannelIterator & operator+=(size_t i) {
+				pointer += i*2*batchLanes;
+				return *this;
+			}
+			BatchChannelIterator & operator++() {
+				pointer += 2*batchLanes;
+				return *this;
+			}
+		};
+
+		template<class Kernel>
+		void fftStepBatch(complex *origData, const Step &step) {
+			const size_t stride = step.innerRepeats;
+			const complex *twiddles = _plan->twiddleVector.data() + step.twiddleIndex;
+			for (size_t outerRepeat = 0; outerRepeat < step.outerRepeats; ++outerRepeat) {
+				Kernel::template run<BatchAccess>(origData, twiddles, stride, 0, stride);
+				origData += step.factor*stride*batchLanes;
+			}
+		}
+
+		template<bool inverse>
+		void runStepsBatch(complex *data) {
+			for (const Step &step : _plan->steps) {
+				complex *stepData = data + step.startIndex*batchLanes;
+				switch (step.type) {
+					case StepType::step2:
+						fftStepBatch<Kernel2<inverse, false>>(stepData, step);
+						break;
+					case StepType::step3:
+						fftStepBatch<Kernel3<inverse, false>>(stepData, step);
+						break;
+					case StepType::step4:
+						fftStepBatch<Kernel4<inverse, false>>(stepData, step);
+						break;
+					case StepType::step5:
+						fftStepBatch<Kernel5<inverse, false>>(stepData, step);
+						break;
+					case StepType::step8:
+						fftStepBatch<Kernel8<inverse, false>>(stepData, step);
+						break;
+					case StepType::step16:
+						fftStepBatch<Kernel16<inverse, false>>(stepData, step);
+						break;
+					case StepType::split:
+						break;
+					default:
+						// Other steps run one channel at a time
+						for (size_t lane = 0; lane < batchLanes; ++lane) {
+							runStep<inverse, false>(BatchChannelIterator{reinterpret_cast<V *>(data) + lane}, step);
+						}
+				}
+			}
+		}
+
+		// Without SIMD lanes (or for non-contiguous data), channels are processed individually
+		template<bool inverse, typename InputIterator, typename OutputIterator, typename HasLanes>
+		void runBatch(HasLanes, InputIterator input, OutputIterator output, size_t channels, size_t channelStride, complex * =nullptr) {
+			for (size_t channel = 0; channel < channels; ++channel) {
+				run<inverse>(input + channel*channelStride, output + channel*channelStride);
+			}
+		}
+		template<bool inverse>
+		void runBatch(std::true_type, complex *input, complex *output, size_t channels, size_t channelStride, complex *batchData=nullptr) {
+			runBatch<inverse>(std::true_type(), (const complex *)input, output, channels, channelStride, batchData);
+		}
+		// `batchData` (size*batchLanes) can be passed in, otherwise we use `batchVector`
+		template<bool inverse>
+		void runBatch(std::true_type, const complex *input, complex *output, size_t channels, size_t channelStride, complex *batchData=nullptr) {
+			size_t channel = 0;
+			// Split-radix and Stockham plans don't have the steps which `runStepsBatch()` uses
+			if (!_plan->useBluestein && !_plan->useSixStep && !_plan->useSplitRadix && !_plan->useStockham) {
+				if (!batchData) {
+					batchVector.resize(_size*batchLanes);
+					batchData = batchVector.data();
+				}
+				complex *data = batchData;
+				const complex *channelInputs[batchLanes];
+				complex *channelOutputs[batchLanes];
+				for (; channel + batchLanes <= channels; channel += batchLanes) {
+					for (size_t lane = 0; lane < batchLanes; ++lane) {
+						channelInputs[lane] = input + (channel + lane)*channelStride;
+						channelOutputs[lane] = output + (channel + lane)*channelStride;
+					}
+					// Permute while interleaving
+					_plan->forEachPermutation(0, _size, [&](size_t from, size_t to) {
+						BatchAccess::store(data, from, BatchAccess::gather(channelInputs, to));
+					});
+					runStepsBatch<inverse>(data);
+					for (size_t i = 0; i < _size; ++i) {
+						BatchAccess::scatter(BatchAccess::load(data, i), channelOutputs, i);
+					}
+				}
+			}
+			for (; channel < channels; ++channel) {
+				run<inverse>(input + channel*channelStride, output + channel*channelStride);
+			}
+		}
+
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		void runUnordered(InputIterator &&input, OutputIterator &&data) {
+			if (!_size) return;
+			if (_plan->useBluestein) return runBluestein<inverse>(input, data);
+			if (_plan->useSixStep) return runSixStep<inverse, true>(input, data);
+			// Stockham plans are already in order, so they're as fast as the unordered steps
+			if (_plan->useStockham) return runStockham<inverse>(input, data);
+
+			auto contiguousData = contiguous(data);
+			if (!sameData(contiguous(input), contiguousData)) {
+				for (size_t i = 0; i < _size; ++i) data[i] = input[i];
+			}
+			if (inverse) {
+				runSteps<inverse>(contiguousData);
+			} else {
+				runStepsTransposed<inverse>(contiguousData);
+			}
+		}
+
+	public:
+		static size_t sizeMinimum(size_t size) {
+			return Plan::sizeMinimum(size);
+		}
+		static size_t sizeMaximum(size_t size) {
+			return Plan::sizeMaximum(size);
+		}
+
+		// All the working memory (and any plans it makes) uses the allocator
+		FFT(size_t size, int fastDirection=0, const Allocator &allocator=Allocator()) : allocator(allocator), _size(0) {
+			if (fastDirection > 0) size = sizeMinimum(size);
+			if (fastDirection < 0) size = sizeMaximum(size);
+			this->setSize(size);
+		}
+		FFT(size_t size, const Allocator &allocator) : FFT(size, 0, allocator) {}
+		// Uses an existing plan, which can be shared with other FFTs
+		FFT(std::shared_ptr<const Plan> plan, const Allocator &allocator=Allocator()) : allocator(allocator), _size(0) {
+			setPlan(plan);
+		}
+
+		size_t setSize(size_t size) {
+			if (_plan && size == _size) return _size;
+			for (size_t i = 0; i < reserved.size(); ++i) {
+				if (reserved[i].plan->size() != size) continue;
+				swapReserved(reserved[i]);
+				// The old state is only kept if it was reserved as well
+				if (!currentReserved) reserved.erase(reserved.begin() + i);
+				currentReserved = true;
+				return _size;
+			}
+			setPlan(std::allocate_shared<Plan>(allocator, size, allocator));
+			return _size;
+		}
+		size_t setSizeMinimum(size_t size) {
+			return setSize(sizeMinimum(size));
+		}
+		size_t setSizeMaximum(size_t size) {
+			return setSize(sizeMaximum(size));
+		}
+		const size_t & size() const {
+			return _size;
+		}
+
+		// The plan is immutable, so it can be shared between threads: each thread has its own `FFT` (which only holds working memory) using the same plan
+		std::shared_ptr<const Plan> plan() const {
+			return _plan;
+		}
+		void setPlan(std::shared_ptr<const Plan> plan) {
+			if (currentReserved) {
+				reserved.emplace_back(allocator);
+				swapReserved(reserved.back());
+				currentReserved = false;
+			}
+			_plan = plan;
+			_size = plan->size();
+			setWorkingMemory();
+		}
+
+		// Prepares the plan and working memory for `size` up-front, so that `setSize(size)` (and computing it, including batches and in-place) doesn't allocate.
+		// Call this for each size you'll switch between, e.g. before real-time processing starts.
+		std::shared_ptr<const Plan> reserve(size_t size) {
+			if (batchVector.capacity() < size*batchLanes) batchVector.reserve(size*batchLanes);
+			if (_plan && size == _size) {
+				_plan->setCycles();
+				currentReserved = true;
+				return _plan;
+			}
+			for (auto &entry : reserved) {
+				if (entry.plan->size() == size) return entry.plan;
+			}
+			// Build the working memory in-place, then swap back
+			Reserved entry(allocator);
+			entry.plan = std::allocate_shared<Plan>(allocator, size, allocator);
+			entry.plan->setCycles();
+			swapReserved(entry);
+			setWorkingMemory();
+			swapReserved(entry);
+			reserved.push_back(std::move(entry));
+			return reserved.back().plan;
+		}
+
+		// Large transforms (where the sub-FFTs don't fit in cache) can be split across threads, e.g. using `FFTThreadPool`.
+		// The executor isn't owned by the FFT, so it must stay alive until it's removed (with `nullptr`) or the FFT is destroyed.
+		void setExecutor(FFTExecutor *executor) {
+			this->executor = executor;
+			if (_plan) sixStepWork.buffer.resize(sixStepBufferSize(*_plan));
+			for (auto &entry : reserved) {
+				entry.sixStepWork.buffer.resize(sixStepBufferSize(*entry.plan));
+			}
+		}
+
+		template<typename InputIterator, typename OutputIterator>
+		void fft(InputIterator &&input, OutputIterator &&output) {
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return run<false>(inputIter, outputIter);
+		}
+
+		template<typename InputIterator, typename OutputIterator>
+		void ifft(InputIterator &&input, OutputIterator &&output) {
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return run<true>(inputIter, outputIter);
+		}
+
+		// In-place versions
+		template<typename RandomAccessIterator>
+		void fft(RandomAccessIterator &&data) {
+			auto dataIter = GetIterator<RandomAccessIterator>::get(data);
+			return run<false>(dataIter, dataIter);
+		}
+		template<typename RandomAccessIterator>
+		void ifft(RandomAccessIterator &&data) {
+			auto dataIter = GetIterator<RandomAccessIterator>::get(data);
+			return run<true>(dataIter, dataIter);
+		}
+
+		// Transforms several channels, where channel `c` starts at `input[c*channelStride]` (and the same for the output)
+		template<typename InputIterator, typename OutputIterator>
+		void fftBatch(InputIterator &&input, OutputIterator &&output, size_t channels, size_t channelStride) {
+			if (!_size) return;
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return runBatch<false>(std::integral_constant<bool, (batchLanes > 1)>(), contiguous(inputIter), contiguous(outputIter), channels, channelStride);
+		}
+		template<typename InputIterator, typename OutputIterator>
+		void ifftBatch(InputIterator &&input, OutputIterator &&output, size_t channels, size_t channelStride) {
+			if (!_size) return;
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return runBatch<true>(std::integral_constant<bool, (batchLanes > 1)>(), contiguous(inputIter), contiguous(outputIter), channels, channelStride);
+		}
+
+		// Unordered transforms skip the permutation, so the spectrum is in a scrambled (but consistent) order.
+		// This is fine for element-wise operations like convolution, and unorderedIndices() gives the position of each bin.
+		template<typename InputIterator, typename OutputIterator>
+		void fftUnordered(InputIterator &&input, OutputIterator &&output) {
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return runUnordered<false>(inputIter, outputIter);
+		}
+		template<typename InputIterator, typename OutputIterator>
+		void ifftUnordered(InputIterator &&input, OutputIterator &&output) {
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return runUnordered<true>(inputIter, outputIter);
+		}
+		template<typename RandomAccessIterator>
+		void fftUnordered(RandomAccessIterator &&data) {
+			auto dataIter = GetIterator<RandomAccessIterator>::get(data);
+			return runUnordered<false>(dataIter, dataIter);
+		}
+		template<typename RandomAccessIterator>
+		void ifftUnordered(RandomAccessIterator &&data) {
+			auto dataIter = GetIterator<RandomAccessIterator>::get(data);
+			return runUnordered<true>(dataIter, dataIter);
+		}
+		// Fills `indices` so that bin `i` is at `indices[i]` in the unordered spectrum
+		template<typename RandomAccessIterator>
+		void unorderedIndices(RandomAccessIterator &&indices) const {
+			_plan->unorderedIndices(indices);
+		}
+	};
+
+	namespace perf {
+		// Compile-time equivalents of the default `FFTPlan` (smallest factors first, with pairs of 2s as radix-4)
+		constexpr size_t fixedSmallestFactor(size_t size, size_t factor=2) {
+			return (factor*factor > size) ? size : (size%factor == 0) ? factor : fixedSmallestFactor(size, factor + 1);
+		}
+		constexpr size_t fixedRadix(size_t length) {
+			return (length%4 == 0) ? 4 : fixedSmallestFactor(length);
+		}
+		// The input index which the permutation moves to `index`: each step's sub-FFTs are decimated by its radix (with radix-4 in bit-reversed order)
+		constexpr size_t fixedDigit(size_t digit, size_t radix) {
+			return (radix == 4) ? ((digit&1)*2 + digit/2) : digit;
+		}
+		constexpr size_t fixedInputIndex(size_t index, size_t length) {
+			return (length <= 1) ? 0 : fixedDigit(index/(length/fixedRadix(length)), fixedRadix(length)) + fixedRadix(length)*fixedInputIndex(index%(length/fixedRadix(length)), length/fixedRadix(length));
+		}
+		constexpr bool fixedValidSize(size_t size) {
+			return size <= 1 || (fixedSmallestFactor(size) <= 5 && fixedValidSize(size/fixedSmallestFactor(size)));
+		}
+
+		// Like C++14's std::index_sequence, with logarithmic template depth
+		template<size_t... I>
+		struct Indices {};
+		template<class A, class B>
+		struct ConcatIndices;
+		template<size_t... A, size_t... B>
+		struct ConcatIndices<Indices<A...>, Indices<B...>> {
+			using type = Indices<A..., (sizeof...(A) + B)...>;
+		};
+		template<size_t N>
+		struct MakeIndices {
+			using type = typename ConcatIndices<typename MakeIndices<N/2>::type, typename MakeIndices<N - N/2>::type>::type;
+		};
+		template<>
+		struct MakeIndices<0> {
+			using type = Indices<>;
+		};
+		template<>
+		struct MakeIndices<1> {
+			using type = Indices<0>;
+		};
+	}
+
+	// An FFT whose size is known at compile-time, for lots of small transforms.  The steps and permutation are unrolled, and it doesn't allocate any memory.
+	// It uses the same steps and butterflies as `FFT`, so the results are identical.  Sizes must only have factors of 2, 3 and 5.
+	template<typename V, size_t N>
+	class FixedFFT {
+		static_assert(perf::fixedValidSize(N), "FixedFFT sizes can only have factors of 2, 3 and 5");
+		using complex = std::complex<V>;
+		using Kernels = FFT<V>;
+
+		template<size_t factor, bool inverse>
+		struct Kernel;
+		template<bool inverse>
+		struct Kernel<2, inverse> : public Kernels::template Kernel2<inverse, false> {};
+		template<bool inverse>
+		struct Kernel<3, inverse> : public Kernels::template Kernel3<inverse, false> {};
+		template<bool inverse>
+		struct Kernel<4, inverse> : public Kernels::template Kernel4<inverse, false> {};
+		template<bool inverse>
+		struct Kernel<5, inverse> : public Kernels::template Kernel5<inverse, false> {};
+
+		// The steps for a sub-FFT of `length` (innermost first), which is repeated `N/length` times
+		template<size_t length, bool=(length > 1)>
+		struct Steps {
+			static constexpr size_t factor = perf::fixedRadix(length), subLength = length/factor;
+			using Inner = Steps<subLength>;
+			static constexpr size_t twiddleIndex = Inner::twiddleCount;
+			static constexpr size_t twiddleCount = twiddleIndex + (factor - 1)*subLength;
+
+			static void addTwiddles(complex *twiddles, const perf::UnitRoots &roots) {
+				Inner::addTwiddles(twiddles, roots);
+				// Same layout and values as `FFTPlan::addPlanSteps()`
+				for (size_t f = 1; f < factor; ++f) {
+					for (size_t i = 0; i < subLength; ++i) {
+						twiddles[twiddleIndex + (f - 1)*subLength + i] = roots.get<V>(i*f*(N/length));
+					}
+				}
+			}
+			template<bool inverse, typename RandomAccessIterator>
+			static SIGNALSMITH_INLINE void run(RandomAccessIterator data, const complex *twiddles) {
+				Inner::template run<inverse>(data, twiddles);
+				using Kernel = FixedFFT::Kernel<factor, inverse>;
+				perf::ButterflyRepeats<Kernel, V, RandomAccessIterator>::run(data, twiddles + twiddleIndex, subLength, subLength, N/length, length);
+			}
+		};
+		template<size_t length>
+		struct Steps<length, false> {
+			static constexpr size_t twiddleCount = 0;
+			static void addTwiddles(complex *, const perf::UnitRoots &) {}
+			template<bool inverse, typename RandomAccessIterator>
+			static SIGNALSMITH_INLINE void run(RandomAccessIterator, const complex *) {}
+		};
+
+		struct Twiddles {
+			std::array<complex, Steps<N>::twiddleCount> values;
+			Twiddles() {
+				Steps<N>::addTwiddles(values.data(), perf::UnitRoots(N));
+			}
+		};
+		static const complex * twiddles() {
+			static const Twiddles table;
+			return table.values.data();
+		}
+
+		template<typename InputIterator, typename OutputIterator, size_t... I>
+		static SIGNALSMITH_INLINE void permute(InputIterator input, OutputIterator data, perf::Indices<I...>) {
+			// Braced lists are evaluated in order, and the indices are compile-time constants
+			int unused[] = {0, ((void)(data[I] = input[std::integral_constant<size_t, perf::fixedInputIndex(I, N)>::value]), 0)...};
+			(void)unused;
+		}
+
+		template<bool inverse, typename InputIterator, typename OutputIterator>
+		static void run(InputIterator input, OutputIterator data) {
+			using Indices = typename perf::MakeIndices<N>::type;
+			auto contiguousData = Kernels::contiguous(data);
+			if (Kernels::sameData(Kernels::contiguous(input), contiguousData)) {
+				std::array<complex, N> copy;
+				for (size_t i = 0; i < N; ++i) copy[i] = contiguousData[i];
+				permute(copy.data(), contiguousData, Indices());
+			} else {
+				permute(input, data, Indices());
+			}
+			Steps<N>::template run<inverse>(contiguousData, twiddles());
+		}
+	public:
+		static constexpr size_t size() {
+			return N;
+		}
+
+		template<typename InputIterator, typename OutputIterator>
+		static void fft(InputIterator &&input, OutputIterator &&output) {
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return run<false>(inputIter, outputIter);
+		}
+		template<typename InputIterator, typename OutputIterator>
+		static void ifft(InputIterator &&input, OutputIterator &&output) {
+			auto inputIter = GetIterator<InputIterator>::get(input);
+			auto outputIter = GetIterator<OutputIterator>::get(output);
+			return run<true>(inputIter, outputIter);
+		}
+
+		// In-place versions
+		template<typename RandomAccessIterator>
+		static void fft(RandomAccessIterator &&data) {
+			auto dataIter = GetIterator<RandomAccessIterator>::get(data);
+			return run<false>(dataIter, dataIter);
+		}
+		template<typename RandomAccessIterator>
+		static void ifft(RandomAccessIterator &&data) {
+			auto dataIter = GetIterator<RandomAccessIterator>::get(data);
+			return run<true>(dataIter, dataIter);
+		}
+	};
+
+	// Remembers the fastest plan shape for each size (measured on this machine), and can save/load them to a file
+	class FFTWisdom {
+		using Key = std::pair<size_t, size_t>; // (sizeof(V), size)
+		std::map<Key, FFTPlanShape> shapes;
+		mutable std::mutex mutex;
+	public:
+		double secondsPerShape = 0.002;
+		bool measure = true; // If false, sizes without any wisdom get the default plan
+
+		template<typename V, class Allocator=FFTAllocator<std::complex<V>>>
+		std::shared_ptr<const FFTPlan<V, Allocator>> plan(size_t size, const Allocator &allocator=Allocator()) {
+			using Plan = FFTPlan<V, Allocator>;
+			Key key{sizeof(V), size};
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto iter = shapes.find(key);
+				if (iter != shapes.end()) return std::allocate_shared<Plan>(allocator, size, iter->second, allocator);
+			}
+			if (!measure) return std::allocate_shared<Plan>(allocator, size, allocator);
+
+			auto plan = Plan::measure(size, secondsPerShape, allocator);
+			std::lock_guard<std::mutex> lock(mutex);
+			shapes[key] = plan->shape();
+			return plan;
+		}
+
+		size_t count() const {
+			std::lock_guard<std::mutex> lock(mutex);
+			return shapes.size();
+		}
+		void clear() {
+			std::lock_guard<std::mutex> lock(mutex);
+			shapes.clear();
+		}
+
+		// One line per size: "valueBytes size splitBytes splitRadix stockham sixStep radix radix ..." (version 1 didn't have `splitRadix`, version 2 didn't have `stockham`, and version 3 didn't have `sixStep`)
+		void save(std::ostream &output) const {
+			std::lock_guard<std::mutex> lock(mutex);
+			output << "signalsmith-fft-wisdom 4\n";
+			for (auto &pair : shapes) {
+				output << pair.first.first << " " << pair.first.second << " " << pair.second.splitBytes << " " << pair.second.splitRadix << " " << pair.second.stockham << " " << pair.second.sixStep;
+				for (size_t radix : pair.second.radices) output << " " << radix;
+				output << "\n";
+			}
+		}
+		// Adds to (or replaces) the existing wisdom, and returns false if the input isn't valid
+		bool load(std::istream &input) {
+			std::string line;
+			if (!std::getline(input, line)) return false;
+			int version = 0;
+			for (int v = 1; v <= 4; ++v) {
+				if (line == "signalsmith-fft-wisdom " + std::to_string(v)) version = v;
+			}
+			if (!version) return false;
+			std::map<Key, FFTPlanShape> loaded;
+			while (std::getline(input, line)) {
+				if (line.empty()) continue;
+				std::istringstream lineStream(line);
+				Key key;
+				FFTPlanShape shape;
+				if (!(lineStream >> key.first >> key.second >> shape.splitBytes)) return false;
+				if (version >= 2 && !(lineStream >> shape.splitRadix)) return false;
+				if (version >= 3 && !(lineStream >> shape.stockham)) return false;
+				if (version >= 4 && !(lineStream >> shape.sixStep)) return false;
+				size_t radix, product = 1;
+				while (lineStream >> radix) {
+					shape.radices.push_back(radix);
+					product *= radix;
+				}
+				if (!lineStream.eof() || product != std::max<size_t>(key.second, 1)) return false;
+				// Earlier versions didn't measure sizes of 16MB or more (they always used six-step), so those lines don't say anything
+				if (version < 4 && 2*key.first*key.second >= (size_t(1)<<24)) continue;
+				loaded[key] = shape;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto &pair : loaded) shapes[pair.first] = pair.second;
+			return true;
+		}
+		bool save(const std::string &filename) const {
+			std::ofstream output(filename);
+			save(output);
+			return (bool)output;
+		}
+		bool load(const std::string &filename) {
+			std::ifstream input(filename);
+			return input && load(input);
+		}
+	};
+
+	struct FFTOptions {
+		static constexpr int halfFreqShift = 1;
+	};
+
+	template<typename V, int optionFlags=0, class Allocator=FFTAllocator<std::complex<V>>>
+	class RealFFT {
+		static constexpr bool modified = (optionFlags&FFTOptions::halfFreqShift);
+
+		using complex = std::complex<V>;
+		template<typename T>
+		using Vector = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+		// The complex FFT runs in-place, directly in the output when that's contiguous (see `directBuffer()`).  This is only used for other iterators, but it's allocated by `setSize()` so that computing the FFT doesn't allocate.
+		Vector<complex> complexBuffer;
+		// The pre/post-processing tables for one size
+		struct Tables {
+			size_t size = 0;
+			Vector<complex> twiddlesMinusI, modifiedRotations;
+			// Only needed for unordered transforms, so it's built on first use (see `setUnorderedIndices()`)
+			Vector<size_t> unorderedIndices;
+
+			explicit Tables(const Allocator &allocator) : twiddlesMinusI(allocator), modifiedRotations(allocator), unorderedIndices(allocator) {}
+
+			void set(size_t size) {
+				this->size = size;
+				// Half-steps are needed for the modified transform
+				perf::UnitRoots roots(2*size);
+				size_t hhSize = size/4 + 1;
+				twiddlesMinusI.resize(hhSize);
+				for (size_t i = 0; i < hhSize; ++i) {
+					complex twiddle = roots.get<V>(modified ? 2*i + 1 : 2*i);
+					twiddlesMinusI[i] = {twiddle.imag(), -twiddle.real()};
+				}
+				if (modified) {
+					modifiedRotations.resize(size/2);
+					for (size_t i = 0; i < size/2; ++i) {
+						modifiedRotations[i] = roots.get<V>(2*i);
+					}
+				}
+				unorderedIndices.clear();
+			}
+			void setUnorderedIndices(const FFTPlan<V, Allocator> &complexPlan) {
+				if (!unorderedIndices.empty()) return;
+				unorderedIndices.resize(size/2);
+				complexPlan.unorderedIndices(unorderedIndices);
+			}
+		};
+		Tables tables;
+		// Tables prepared by `reserve()`, which are swapped with the current ones (like `FFT::reserve()`)
+		Vector<Tables> reserved;
+		bool currentReserved = false;
+		FFT<V, Allocator> complexFft;
+
+		// Contiguous complex spectra, or contiguous real signals (as pairs), can hold the complex FFT's data directly
+		static complex * directBuffer(complex *pointer) {
+			return pointer;
+		}
+		static complex * directBuffer(V *pointer) {
+			return reinterpret_cast<complex *>(pointer);
+		}
+		template<class A>
+		static complex * directBuffer(std::vector<complex, A> &vector) {
+			return vector.data();
+		}
+		template<class A>
+		static complex * directBuffer(std::vector<V, A> &vector) {
+			return reinterpret_cast<complex *>(vector.data());
+		}
+		template<class T>
+		static complex * directBuffer(T &&) {
+			return nullptr;
+		}
+		template<typename OutputIterator>
+		complex * workingBuffer(OutputIterator &output) {
+			complex *buffer = directBuffer(output);
+			if (buffer) return buffer;
+			return complexBuffer.data();
+		}
+
+		// Bins are read/written via `binIndex()`, so the same pre/post-processing works for the unordered spectrum
+		template<bool unordered>
+		size_t binIndex(size_t i) const {
+			return unordered ? tables.unorderedIndices[i] : i;
+		}
+
+		template<bool unordered, typename InputIterator, typename OutputIterator>
+		void runForward(InputIterator &&input, OutputIterator &&output) {
 			size_t hSize = complexFft.size();
+			if (unordered) tables.setUnorderedIndices(*complexFft.plan());
+			// Each value is read before it's written, so this can be the same memory as the input
+			complex *buffer = workingBuffer(output);
 			for (size_t i = 0; i < hSize; ++i) {
 				if (modified) {
-					complexBuffer1[i] = perf::complexMul<false>({input[2*i], input[2*i + 1]}, modifiedRotations[i]);
+					buffer[i] = perf::complexMul<false>({input[2*i], input[2*i + 1]}, tables.modifiedRotations[i]);
 				} else {
-					complexBuffer1[i] = {input[2*i], input[2*i + 1]};
+					buffer[i] = {input[2*i], input[2*i + 1]};
 				}
 			}
 			
-			complexFft.fft(complexBuffer1.data(), complexBuffer2.data());
+			if (unordered) {
+				complexFft.fftUnordered(buffer);
+			} else {
+				complexFft.fft(buffer);
+			}
 			
+			// Bin 0 is always at index 0
 			if (!modified) output[0] = {
-				complexBuffer2[0].real() + complexBuffer2[0].imag(),
-				complexBuffer2[0].real() - complexBuffer2[0].imag()
+				buffer[0].real() + buffer[0].imag(),
+				buffer[0].real() - buffer[0].imag()
 			};
-			for (size_t i = modified ? 0 : 1; i <= hSize/2; ++i) {
+			// Each (i, conjI) pair is visited once, since the output can be the same memory
+			const size_t pairEnd = modified ? (hSize + 1)/2 : hSize/2 + 1;
+			for (size_t i = modified ? 0 : 1; i < pairEnd; ++i) {
 				size_t conjI = modified ? (hSize  - 1 - i) : (hSize - i);
+				size_t index = binIndex<unordered>(i), conjIndex = binIndex<unordered>(conjI);
 				
-				complex odd = (complexBuffer2[i] + conj(complexBuffer2[conjI]))*(V)0.5;
-				complex evenI = (complexBuffer2[i] - conj(complexBuffer2[conjI]))*(V)0.5;
-				complex evenRotMinusI = perf::complexMul<false>(evenI, twiddlesMinusI[i]);
+				complex odd = (buffer[index] + conj(buffer[conjIndex]))*(V)0.5;
+				complex evenI = (buffer[index] - conj(buffer[conjIndex]))*(V)0.5;
+				complex evenRotMinusI = perf::complexMul<false>(evenI, tables.twiddlesMinusI[i]);
 
-				output[i] = odd + evenRotMinusI;
-				output[conjI] = conj(odd - evenRotMinusI);
+				output[index] = odd + evenRotMinusI;
+				output[conjIndex] = conj(odd - evenRotMinusI);
 			}
 		}
 
-		template<typename InputIterator, typename OutputIterator>
-		void ifft(InputIterator &&input, OutputIterator &&output) {
+		template<bool unordered, typename InputIterator, typename OutputIterator>
+		void runInverse(InputIterator &&input, OutputIterator &&output) {
 			size_t hSize = complexFft.size();
-			if (!modified) complexBuffer1[0] = {
+			if (unordered) tables.setUnorderedIndices(*complexFft.plan());
+			complex *buffer = workingBuffer(output);
+			if (!modified) buffer[0] = {
 				input[0].real() + input[0].imag(),
 				input[0].real() - input[0].imag()
 			};
-			for (size_t i = modified ? 0 : 1; i <= hSize/2; ++i) {
+			const size_t pairEnd = modified ? (hSize + 1)/2 : hSize/2 + 1;
+			for (size_t i = modified ? 0 : 1; i < pairEnd; ++i) {
 				size_t conjI = modified ? (hSize  - 1 - i) : (hSize - i);
-				complex v = input[i], v2 = input[conjI];
+				size_t index = binIndex<unordered>(i), conjIndex = binIndex<unordered>(conjI);
+				complex v = input[index], v2 = input[conjIndex];
 
 				complex odd = v + conj(v2);
 				complex evenRotMinusI = v - conj(v2);
-				complex evenI = perf::complexMul<true>(evenRotMinusI, twiddlesMinusI[i]);
+				complex evenI = perf::complexMul<true>(evenRotMinusI, tables.twiddlesMinusI[i]);
 				
-				complexBuffer1[i] = odd + evenI;
-				complexBuffer1[conjI] = conj(odd - evenI);
+				buffer[index] = odd + evenI;
+				buffer[conjIndex] = conj(odd - evenI);
 			}
 			
-			complexFft.ifft(complexBuffer1.data(), complexBuffer2.data());
+			if (unordered) {
+				complexFft.ifftUnordered(buffer);
+			} else {
+				complexFft.ifft(buffer);
+			}
 			
+			if (!modified && buffer == directBuffer(output)) return;
 			for (size_t i = 0; i < hSize; ++i) {
-				complex v = complexBuffer2[i];
-				if (modified) v = perf::complexMul<true>(v, modifiedRotations[i]);
+				complex v = buffer[i];
+				if (modified) v = perf::complexMul<true>(v, tables.modifiedRotations[i]);
 				output[2*i] = v.real();
 				output[2*i + 1] = v.imag();
 			}
 		}
+	public:
+		static size_t sizeMinimum(size_t size) {
+			return FFT<V>::sizeMinimum((size + 1)/2)*2;
+		}
+		static size_t sizeMaximum(size_t size) {
+			return FFT<V>::sizeMaximum(size/2)*2;
+		}
+
+		RealFFT(size_t size, int fastDirection=0, const Allocator &allocator=Allocator()) : complexBuffer(allocator), tables(allocator), reserved(allocator), complexFft(0, allocator) {
+			if (fastDirection > 0) size = sizeMinimum(size);
+			if (fastDirection < 0) size = sizeMaximum(size);
+			this->setSize(size);
+		}
+		RealFFT(size_t size, const Allocator &allocator) : RealFFT(size, 0, allocator) {}
+
+		size_t setSize(size_t size) {
+			complexFft.setSize(size/2);
+			complexBuffer.resize(complexFft.size());
+			// The complex FFT always runs in-place
+			complexFft.plan()->prepareInPlace();
+			if (!tables.twiddlesMinusI.empty() && size == tables.size) return complexFft.size();
+			for (size_t i = 0; i < reserved.size(); ++i) {
+				if (reserved[i].size != size) continue;
+				std::swap(tables, reserved[i]);
+				if (!currentReserved) reserved.erase(reserved.begin() + i);
+				currentReserved = true;
+				return complexFft.size();
+			}
+			if (currentReserved) {
+				reserved.push_back(std::move(tables));
+				tables = Tables(complexBuffer.get_allocator());
+				currentReserved = false;
+			}
+			tables.set(size);
+			return complexFft.size();
+		}
+		// Prepares everything for `size` up-front (see `FFT::reserve()`), so that `setSize(size)` doesn't allocate
+		void reserve(size_t size) {
+			auto complexPlan = complexFft.reserve(size/2);
+			if (complexBuffer.capacity() < size/2) complexBuffer.reserve(size/2);
+			// Unordered transforms shouldn't allocate either
+			if (!tables.twiddlesMinusI.empty() && size == tables.size) {
+				tables.setUnorderedIndices(*complexPlan);
+				currentReserved = true;
+				return;
+			}
+			for (auto &entry : reserved) {
+				if (entry.size == size) return;
+			}
+			reserved.emplace_back(complexBuffer.get_allocator());
+			reserved.back().set(size);
+			reserved.back().setUnorderedIndices(*complexPlan);
+		}
+		size_t setSizeMinimum(size_t size) {
+			return setSize(sizeMinimum(size));
+		}
+		size_t setSizeMaximum(size_t size) {
+			return setSize(sizeMaximum(size));
+		}
+		size_t size() const {
+			return complexFft.size()*2;
+		}
+		// The complex FFT is split across threads (see `FFT::setExecutor()`), but the real pre/post-processing isn't
+		void setExecutor(FFTExecutor *executor) {
+			complexFft.setExecutor(executor);
+		}
+
+		template<typename InputIterator, typename OutputIterator>
+		void fft(InputIterator &&input, OutputIterator &&output) {
+			runForward<false>(input, output);
+		}
+		template<typename InputIterator, typename OutputIterator>
+		void ifft(InputIterator &&input, OutputIterator &&output) {
+			runInverse<false>(input, output);
+		}
+
+		// The spectrum is in the same order as FFT::fftUnordered(), with the 0 and Nyquist bins still packed into index 0
+		template<typename InputIterator, typename OutputIterator>
+		void fftUnordered(InputIterator &&input, OutputIterator &&output) {
+			runForward<true>(input, output);
+		}
+		template<typename InputIterator, typename OutputIterator>
+		void ifftUnordered(InputIterator &&input, OutputIterator &&output) {
+			runInverse<true>(input, output);
+		}
+	};
+
+	template<typename V, class Allocator=FFTAllocator<std::complex<V>>>
+	struct ModifiedRealFFT : public RealFFT<V, FFTOptions::halfFreqShift, Allocator> {
+		using RealFFT<V, FFTOptions::halfFreqShift, Allocator>::RealFFT;
+	};
+
+	// FIR filter using overlap-save with unordered real FFTs.  The output is delayed by `latency()` samples, which is also the hop size.
+	template<typename V>
+	class Convolver {
+		using complex = std::complex<V>;
+		RealFFT<V> realFft;
+		size_t _latency = 0, _filterLength = 0;
+		// Position within the current block
+		size_t blockIndex = 0;
+		// The filter spectrum includes the 1/N scaling, so the result needs no further normalisation
+		std::vector<complex> filterSpectrum, spectrum;
+		// The most recent `fftSize` inputs, and the (non-aliased) results of the last block
+		std::vector<V> inputBuffer, outputBuffer;
+
+		void processBlock() {
+			const size_t fftSize = realFft.size(), hSize = fftSize/2;
+			realFft.fftUnordered(inputBuffer, spectrum);
+			// The 0 and Nyquist bins are packed into index 0, and multiplied separately
+			spectrum[0] = {spectrum[0].real()*filterSpectrum[0].real(), spectrum[0].imag()*filterSpectrum[0].imag()};
+			for (size_t i = 1; i < hSize; ++i) {
+				spectrum[i] = perf::complexMul<false>(spectrum[i], filterSpectrum[i]);
+			}
+			realFft.ifftUnordered(spectrum, outputBuffer);
+
+			// Keep the overlapping part of the input
+			for (size_t i = _latency; i < fftSize; ++i) {
+				inputBuffer[i - _latency] = inputBuffer[i];
+			}
+		}
+	public:
+		Convolver() : realFft(0) {}
+		template<typename InputIterator>
+		Convolver(InputIterator &&filter, size_t filterLength, size_t blockSize=0) : realFft(0) {
+			setFilter(filter, filterLength, blockSize);
+		}
+
+		// Sets the impulse response.  If `blockSize` is 0, it picks the FFT size from the filter length.
+		template<typename InputIterator>
+		void setFilter(InputIterator &&filter, size_t filterLength, size_t blockSize=0) {
+			if (filterLength < 1) filterLength = 1;
+			size_t fftSize;
+			if (blockSize > 0) {
+				fftSize = RealFFT<V>::sizeMinimum(blockSize + filterLength - 1);
+			} else {
+				fftSize = RealFFT<V>::sizeMinimum(filterLength*2);
+				blockSize = fftSize - filterLength + 1;
+			}
+			realFft.setSize(fftSize);
+			_latency = blockSize;
+			_filterLength = filterLength;
+
+			filterSpectrum.resize(fftSize/2);
+			spectrum.resize(fftSize/2);
+			inputBuffer.assign(fftSize, 0);
+			outputBuffer.assign(fftSize, 0);
+
+			V scale = V(1)/fftSize;
+			for (size_t i = 0; i < fftSize; ++i) {
+				inputBuffer[i] = (i < filterLength) ? filter[i]*scale : 0;
+			}
+			realFft.fftUnordered(inputBuffer, filterSpectrum);
+			reset();
+		}
+
+		size_t latency() const {
+			return _latency;
+		}
+		size_t filterLength() const {
+			return _filterLength;
+		}
+		size_t fftSize() const {
+			return realFft.size();
+		}
+
+		// Clears the input history and pending output
+		void reset() {
+			blockIndex = 0;
+			for (auto &v : inputBuffer) v = 0;
+			for (auto &v : outputBuffer) v = 0;
+		}
+
+		// Processes any number of samples.  This doesn't allocate, and `output` can be the same as `input`.
+		template<typename InputIterator, typename OutputIterator>
+		void process(InputIterator &&input, OutputIterator &&output, size_t length) {
+			const size_t fftSize = realFft.size();
+			const size_t offset = fftSize - _latency;
+			size_t i = 0;
+			while (i < length) {
+				size_t chunk = std::min(length - i, _latency - blockIndex);
+				for (size_t j = 0; j < chunk; ++j) {
+					V value = input[i + j];
+					output[i + j] = outputBuffer[offset + blockIndex + j];
+					inputBuffer[offset + blockIndex + j] = value;
+				}
+				i += chunk;
+				blockIndex += chunk;
+				if (blockIndex == _latency) {
+					processBlock();
+					blockIndex = 0;
+				}
+			}
+		}
 	};
 
+	/* Non-uniformly partitioned convolution, for long filters with low latency.
+
+	The output is delayed by `blockSize` samples.  The filter is split into segments of uniform partitions (each with a frequency-domain delay line), and the partition size doubles once there is time to spread a segment's work across several blocks.  All of a larger segment's work (including its FFTs) is split into small steps, which are spread evenly across its cycle of blocks. */
 	template<typename V>
-	struct ModifiedRealFFT : public RealFFT<V, FFTOptions::halfFreqShift> {
-		using RealFFT<V, FFTOptions::halfFreqShift>::RealFFT;
+	class PartitionedConvolver {
+		using complex = std::complex<V>;
+
+		// A real FFT split into small steps which can run in separate blocks.  The complex FFT (of even/odd pairs) is done as `rows*columns`, with sub-FFTs down the columns and then along the rows, but without the transposes.  So bin `k` of the complex FFT ends up at `[(k%rows)*columns + k/rows]`, with the 0 and Nyquist bins packed into index 0 like `RealFFT::fftUnordered()`.
+		struct SplitRealFFT {
+			size_t hSize, rows, columns;
+			FFT<V> columnFft, rowFft;
+			// Twiddles between the column and row FFTs, and for the real pre/post-processing, laid out like the spectrum
+			std::vector<complex> twiddles, realTwiddles;
+			// Several columns/rows can be transformed together (see `FFT::fftBatch()`), but each step is then bigger
+			size_t groupSize = 1;
+			std::vector<complex> groupInput, groupOutput;
+
+			// Columns are as long as possible without being longer than rows, so neither sub-FFT is much bigger than sqrt(hSize)
+			SplitRealFFT(size_t size) : hSize(size/2), rows(1), columns(size/2), columnFft(0), rowFft(0) {
+				for (size_t r = 1; r*r <= hSize; ++r) {
+					if (hSize%r == 0) rows = r;
+				}
+				columns = hSize/rows;
+				columnFft.setSize(rows);
+				rowFft.setSize(columns);
+				setGroupSize(1);
+
+				perf::UnitRoots roots(hSize), realRoots(size);
+				twiddles.resize(hSize);
+				realTwiddles.resize(hSize);
+				for (size_t r = 0; r < rows; ++r) {
+					for (size_t c = 0; c < columns; ++c) {
+						twiddles[r*columns + c] = roots.get<V>(r*c);
+						realTwiddles[r*columns + c] = realRoots.get<V>(r + c*rows);
+					}
+				}
+			}
+
+			size_t size() const {
+				return hSize*2;
+			}
+			void setGroupSize(size_t size) {
+				groupSize = std::max<size_t>(1, std::min<size_t>(size, 8));
+				groupInput.resize(groupSize*rows);
+				groupOutput.resize(groupSize*rows);
+			}
+			size_t columnGroups() const {
+				return (columns + groupSize - 1)/groupSize;
+			}
+			size_t rowGroups() const {
+				return (rows + groupSize - 1)/groupSize;
+			}
+			// Bins `k` and `hSize - k` are in rows `r` and `rows - r` (or both in row 0), so the real pre/post-processing is done for pairs of rows
+			size_t rowPairs() const {
+				return rows/2 + 1;
+			}
+
+			// Reads the real input as `input(index)`
+			template<class Input>
+			void forwardColumns(size_t group, Input &&input, complex *matrix) {
+				size_t from = group*groupSize, count = std::min(groupSize, columns - from);
+				for (size_t r = 0; r < rows; ++r) {
+					for (size_t c = 0; c < count; ++c) {
+						size_t i = r*columns + from + c;
+						groupInput[c*rows + r] = {input(2*i), input(2*i + 1)};
+					}
+				}
+				columnFft.fftBatch(groupInput, groupOutput, count, rows);
+				for (size_t r = 0; r < rows; ++r) {
+					for (size_t c = 0; c < count; ++c) {
+						size_t i = r*columns + from + c;
+						matrix[i] = perf::complexMul<false>(groupOutput[c*rows + r], twiddles[i]);
+					}
+				}
+			}
+			void forwardRows(size_t group, const complex *matrix, complex *spectrum) {
+				size_t from = group*groupSize, count = std::min(groupSize, rows - from);
+				rowFft.fftBatch(matrix + from*columns, spectrum + from*columns, count, columns);
+			}
+			// Each (index, conjIndex) pair is visited once, so this is in-place
+			void forwardReal(size_t rowPair, complex *spectrum) {
+				forEachPair(rowPair, spectrum, [&](size_t index, size_t conjIndex) {
+					complex a = spectrum[index], b = conj(spectrum[conjIndex]);
+					complex even = (a + b)*V(0.5), oddI = (a - b)*V(0.5);
+					complex oddRotated = perf::complexMul<false>(oddI, realTwiddles[index]);
+					// The odd part is `oddI/i`
+					spectrum[index] = perf::complexAddI<true>(even, oddRotated);
+					spectrum[conjIndex] = conj(perf::complexAddI<false>(even, oddRotated));
+				});
+			}
+
+			void inverseReal(size_t rowPair, complex *spectrum) {
+				forEachPair(rowPair, spectrum, [&](size_t index, size_t conjIndex) {
+					complex a = spectrum[index], b = conj(spectrum[conjIndex]);
+					complex even = a + b;
+					complex odd = perf::complexMul<true>(a - b, realTwiddles[index]);
+					spectrum[index] = perf::complexAddI<false>(even, odd);
+					spectrum[conjIndex] = conj(perf::complexAddI<true>(even, odd));
+				});
+			}
+			void inverseRows(size_t group, const complex *spectrum, complex *matrix) {
+				size_t from = group*groupSize, count = std::min(groupSize, rows - from);
+				rowFft.ifftBatch(spectrum + from*columns, matrix + from*columns, count, columns);
+			}
+			void inverseColumns(size_t group, const complex *matrix, V *output) {
+				size_t from = group*groupSize, count = std::min(groupSize, columns - from);
+				for (size_t r = 0; r < rows; ++r) {
+					for (size_t c = 0; c < count; ++c) {
+						size_t i = r*columns + from + c;
+						groupInput[c*rows + r] = perf::complexMul<true>(matrix[i], twiddles[i]);
+					}
+				}
+				columnFft.ifftBatch(groupInput, groupOutput, count, rows);
+				for (size_t r = 0; r < rows; ++r) {
+					for (size_t c = 0; c < count; ++c) {
+						size_t i = r*columns + from + c;
+						output[2*i] = groupOutput[c*rows + r].real();
+						output[2*i + 1] = groupOutput[c*rows + r].imag();
+					}
+				}
+			}
+
+			// Calls `fn(index, conjIndex)` for the bin pairs (k, hSize - k) in rows `r` and `rows - r`, except for bin 0 (which is its own pair, and converted to/from the packed 0/Nyquist bins here)
+			template<class Fn>
+			void forEachPair(size_t r, complex *spectrum, Fn &&fn) {
+				if (r == 0) {
+					spectrum[0] = {
+						spectrum[0].real() + spectrum[0].imag(),
+						spectrum[0].real() - spectrum[0].imag()
+					};
+					// Row 0 holds k = c*rows, paired with column `columns - c`
+					for (size_t c = 1; c <= columns - c; ++c) {
+						fn(c, columns - c);
+					}
+					return;
+				}
+				// Otherwise, column `c` is paired with `columns - 1 - c` in the other row
+				size_t index = r*columns, conjIndex = (rows - r)*columns + columns - 1;
+				for (size_t c = 0; c < columns; ++c) {
+					if (index > conjIndex) break; // row `rows/2` is paired with itself
+					fn(index++, conjIndex--);
+				}
+			}
+		};
+
+		// Rough cost of an FFT, in the same units as `Segment::runBlock()` returns
+		static size_t fftWork(size_t size) {
+			size_t work = size;
+			for (size_t s = 1; s < size; s *= 2) work += size;
+			return work;
+		}
+
+		struct Segment {
+			size_t partitionSize, partitionCount;
+			// Segments further into the filter read delayed input, so their results arrive just in time
+			size_t inputDelay;
+			size_t blocksPerCycle, cycleOffset;
+			// Segments with one block per cycle use a whole (unordered) real FFT, and larger ones split it into steps
+			RealFFT<V> realFft;
+			SplitRealFFT splitFft;
+			// Unordered spectra: one per partition for the filter, and a ring of recent inputs (the delay line)
+			std::vector<complex> filterSpectra, inputSpectra, sumSpectrum;
+			size_t newestInput = 0;
+			std::vector<V> timeBuffer, outputBuffer;
+
+			// Progress through the steps of the current cycle, and where its input starts in the history
+			size_t nextStep = 0, stepCount = 0, workDone = 0, cycleWork = 0;
+			size_t inputStart = 0;
+			// Between the column and row FFTs
+			std::vector<complex> matrix;
+			// Written by the inverse FFT's steps while `outputBuffer` is being read, and swapped at the end of each cycle
+			std::vector<V> nextOutputBuffer;
+
+			Segment(size_t partitionSize, size_t partitionCount, size_t inputDelay, size_t blockSize) : partitionSize(partitionSize), partitionCount(partitionCount), inputDelay(inputDelay), blocksPerCycle(partitionSize/blockSize), realFft(blocksPerCycle == 1 ? RealFFT<V>::sizeMinimum(partitionSize*2) : 0), splitFft(blocksPerCycle == 1 ? 0 : RealFFT<V>::sizeMinimum(partitionSize*2)) {
+				// Start cycles halfway through the previous (half-size) segment's cycle
+				cycleOffset = blocksPerCycle/2;
+				size_t fftSize = this->fftSize(), hSize = fftSize/2;
+				filterSpectra.resize(hSize*partitionCount);
+				inputSpectra.resize(hSize*partitionCount);
+				sumSpectrum.resize(hSize);
+				timeBuffer.resize(fftSize);
+				outputBuffer.resize(fftSize);
+				if (blocksPerCycle == 1) {
+					cycleWork = 2*fftWork(hSize) + 2*hSize + partitionCount*hSize;
+				} else {
+					matrix.resize(hSize);
+					nextOutputBuffer.resize(fftSize);
+					size_t rows = splitFft.rows, columns = splitFft.columns;
+					// The total of what `runStep()` returns
+					cycleWork = 2*(columns*fftWork(rows) + rows*fftWork(columns) + splitFft.rowPairs()*2*columns) + partitionCount*hSize;
+					// Group the sub-FFTs as long as that keeps each step within one block's share of the work
+					splitFft.setGroupSize(cycleWork/blocksPerCycle/fftWork(std::max(rows, columns)));
+					stepCount = 2*(splitFft.columnGroups() + splitFft.rowGroups() + splitFft.rowPairs()) + partitionCount*rows;
+				}
+			}
+
+			size_t fftSize() const {
+				return (blocksPerCycle == 1) ? realFft.size() : splitFft.size();
+			}
+			// The most recent `fftSize()` inputs end this far back from the newest input
+			size_t lookback() const {
+				return inputDelay + fftSize();
+			}
+			// The input is read during the first part of each cycle, so it must stay in the history until then
+			size_t historyNeeded() const {
+				return lookback() + partitionSize;
+			}
+
+			template<typename InputIterator>
+			void setFilter(InputIterator filter, size_t filterLength) {
+				size_t fftSize = this->fftSize(), hSize = fftSize/2;
+				V scale = V(1)/fftSize;
+				for (size_t p = 0; p < partitionCount; ++p) {
+					for (size_t i = 0; i < fftSize; ++i) {
+						size_t index = p*partitionSize + i;
+						timeBuffer[i] = (i < partitionSize && index < filterLength) ? filter[index]*scale : 0;
+					}
+					complex *spectrum = filterSpectra.data() + p*hSize;
+					if (blocksPerCycle == 1) {
+						realFft.fftUnordered(timeBuffer, spectrum);
+					} else {
+						auto input = [&](size_t i) {
+							return timeBuffer[i];
+						};
+						for (size_t g = 0; g < splitFft.columnGroups(); ++g) splitFft.forwardColumns(g, input, matrix.data());
+						for (size_t g = 0; g < splitFft.rowGroups(); ++g) splitFft.forwardRows(g, matrix.data(), spectrum);
+						for (size_t r = 0; r < splitFft.rowPairs(); ++r) splitFft.forwardReal(r, spectrum);
+					}
+				}
+				reset();
+			}
+
+			void reset() {
+				newestInput = 0;
+				nextStep = stepCount;
+				workDone = 0;
+				for (auto &v : inputSpectra) v = 0;
+				for (auto &v : sumSpectrum) v = 0;
+				for (auto &v : outputBuffer) v = 0;
+				for (auto &v : nextOutputBuffer) v = 0;
+			}
+
+			// Adds partition `p`'s contribution to the sum, for bins in `[from, to)`
+			void multiplyAdd(size_t p, size_t from, size_t to) {
+				const size_t hSize = fftSize()/2;
+				const complex *input = inputSpectra.data() + ((newestInput + p)%partitionCount)*hSize;
+				const complex *filter = filterSpectra.data() + p*hSize;
+				size_t i = from;
+				if (i == 0) {
+					// The 0 and Nyquist bins are packed into index 0
+					complex product = {input[0].real()*filter[0].real(), input[0].imag()*filter[0].imag()};
+					sumSpectrum[0] = (p == 0) ? product : sumSpectrum[0] + product;
+					++i;
+				}
+				if (p == 0) {
+					for (; i < to; ++i) {
+						sumSpectrum[i] = perf::complexMul<false>(input[i], filter[i]);
+					}
+				} else {
+					for (; i < to; ++i) {
+						sumSpectrum[i] += perf::complexMul<false>(input[i], filter[i]);
+					}
+				}
+			}
+
+			// Runs one step of the cycle: column FFTs, row FFTs and real post-processing for the new input, the multiply-accumulate (one row of one partition at a time), and then the inverse in reverse order.  Returns the step's work.
+			size_t runStep(size_t step, const std::vector<V> &history) {
+				const size_t rows = splitFft.rows, columns = splitFft.columns, groupSize = splitFft.groupSize;
+				const size_t columnGroups = splitFft.columnGroups(), rowGroups = splitFft.rowGroups(), rowPairs = splitFft.rowPairs();
+				complex *newSpectrum = inputSpectra.data() + newestInput*splitFft.hSize;
+				if (step < columnGroups) {
+					size_t historySize = history.size();
+					auto input = [&](size_t i) {
+						size_t index = inputStart + i;
+						return history[index >= historySize ? index - historySize : index];
+					};
+					splitFft.forwardColumns(step, input, matrix.data());
+					return std::min(groupSize, columns - step*groupSize)*fftWork(rows);
+				}
+				step -= columnGroups;
+				if (step < rowGroups) {
+					splitFft.forwardRows(step, matrix.data(), newSpectrum);
+					return std::min(groupSize, rows - step*groupSize)*fftWork(columns);
+				}
+				step -= rowGroups;
+				if (step < rowPairs) {
+					splitFft.forwardReal(step, newSpectrum);
+					return 2*columns;
+				}
+				step -= rowPairs;
+				if (step < partitionCount*rows) {
+					size_t row = step%rows;
+					multiplyAdd(step/rows, row*columns, (row + 1)*columns);
+					return columns;
+				}
+				step -= partitionCount*rows;
+				if (step < rowPairs) {
+					splitFft.inverseReal(step, sumSpectrum.data());
+					return 2*columns;
+				}
+				step -= rowPairs;
+				if (step < rowGroups) {
+					splitFft.inverseRows(step, sumSpectrum.data(), matrix.data());
+					return std::min(groupSize, rows - step*groupSize)*fftWork(columns);
+				}
+				step -= rowGroups;
+				splitFft.inverseColumns(step, matrix.data(), nextOutputBuffer.data());
+				return std::min(groupSize, columns - step*groupSize)*fftWork(rows);
+			}
+
+			// Runs one block's share of the work, and returns how much work that was (roughly the number of complex multiply-adds).  Each cycle's steps are spread so that the work done by the end of each block is proportional to how far through the cycle it is.
+			size_t runBlock(size_t blockCounter, const std::vector<V> &history, size_t historyEnd) {
+				const size_t fftSize = this->fftSize(), hSize = fftSize/2;
+				size_t phase = (blockCounter + cycleOffset)%blocksPerCycle;
+				if (phase == 0) {
+					size_t historySize = history.size();
+					inputStart = (historyEnd + 2*historySize - lookback())%historySize;
+					newestInput = (newestInput + partitionCount - 1)%partitionCount;
+					nextStep = workDone = 0;
+				}
+
+				if (blocksPerCycle == 1) {
+					size_t historySize = history.size(), index = inputStart;
+					for (size_t i = 0; i < fftSize; ++i) {
+						timeBuffer[i] = history[index];
+						if (++index == historySize) index = 0;
+					}
+					realFft.fftUnordered(timeBuffer, inputSpectra.data() + newestInput*hSize);
+					for (size_t p = 0; p < partitionCount; ++p) {
+						multiplyAdd(p, 0, hSize);
+					}
+					realFft.ifftUnordered(sumSpectrum, outputBuffer);
+					return cycleWork;
+				}
+
+				// Written to avoid overflow: cycleWork*(phase + 1)/blocksPerCycle
+				size_t targetWork = cycleWork/blocksPerCycle*(phase + 1) + cycleWork%blocksPerCycle*(phase + 1)/blocksPerCycle;
+				size_t startWork = workDone;
+				while (workDone < targetWork && nextStep < stepCount) {
+					workDone += runStep(nextStep++, history);
+				}
+				if (phase == blocksPerCycle - 1) {
+					std::swap(outputBuffer, nextOutputBuffer);
+				}
+				return workDone - startWork;
+			}
+
+			// Adds this block's slice of the result (non-aliased part of the output), after `runBlock()`
+			void addOutput(size_t blockCounter, size_t blockSize, V *output) const {
+				size_t phase = (blockCounter + cycleOffset)%blocksPerCycle;
+				size_t offset = fftSize() - partitionSize + ((phase + 1)%blocksPerCycle)*blockSize;
+				for (size_t i = 0; i < blockSize; ++i) {
+					output[i] += outputBuffer[offset + i];
+				}
+			}
+		};
+		std::vector<Segment> segments;
+
+		size_t _blockSize = 0, _filterLength = 0;
+		size_t blockIndex = 0, blockCounter = 0, _blockWork = 0;
+		// Recent input, as a circular buffer
+		std::vector<V> inputHistory;
+		size_t historyIndex = 0;
+		std::vector<V> outputBlock;
+
+		void processBlock() {
+			for (auto &v : outputBlock) v = 0;
+			_blockWork = 0;
+			for (auto &segment : segments) {
+				_blockWork += segment.runBlock(blockCounter, inputHistory, historyIndex);
+				segment.addOutput(blockCounter, _blockSize, outputBlock.data());
+			}
+			++blockCounter;
+		}
+	public:
+		PartitionedConvolver() {}
+		template<typename InputIterator>
+		PartitionedConvolver(InputIterator &&filter, size_t filterLength, size_t blockSize, size_t maxPartitionSize=16384) {
+			setFilter(filter, filterLength, blockSize, maxPartitionSize);
+		}
+
+		// Sets the impulse response, and the block size (which is also the latency).  Partitions are `blockSize` times a power of 2, up to `maxPartitionSize`.
+		template<typename InputIterator>
+		void setFilter(InputIterator &&filter, size_t filterLength, size_t blockSize, size_t maxPartitionSize=16384) {
+			auto filterIter = GetIterator<InputIterator>::get(filter);
+			if (blockSize < 1) blockSize = 1;
+			if (filterLength < 1) filterLength = 1;
+			_blockSize = blockSize;
+			_filterLength = filterLength;
+
+			segments.clear();
+			size_t partitionSize = blockSize, offset = 0, historySize = blockSize;
+			while (offset < filterLength) {
+				size_t segmentStart = offset, count = 0;
+				// Double the partition size once its work (spread over `2*partitionSize/blockSize` blocks) can finish in time
+				size_t nextSize = partitionSize*2;
+				bool canGrow = (nextSize <= maxPartitionSize);
+				while (offset < filterLength && !(canGrow && count > 0 && offset + 2*blockSize >= 2*nextSize)) {
+					offset += partitionSize;
+					++count;
+				}
+				size_t inputDelay = segmentStart + 2*blockSize - 2*partitionSize;
+				segments.emplace_back(partitionSize, count, inputDelay, blockSize);
+				segments.back().setFilter(filterIter + segmentStart, filterLength - segmentStart);
+				historySize = std::max(historySize, segments.back().historyNeeded());
+				partitionSize = nextSize;
+			}
+
+			inputHistory.resize(historySize);
+			outputBlock.resize(blockSize);
+			reset();
+		}
+
+		size_t latency() const {
+			return _blockSize;
+		}
+		size_t filterLength() const {
+			return _filterLength;
+		}
+		// Roughly how many complex multiply-adds the most recent block did (for checking that the work is spread evenly)
+		size_t blockWork() const {
+			return _blockWork;
+		}
+
+		// Clears the input history and pending output
+		void reset() {
+			blockIndex = blockCounter = historyIndex = _blockWork = 0;
+			for (auto &v : inputHistory) v = 0;
+			for (auto &v : outputBlock) v = 0;
+			for (auto &segment : segments) segment.reset();
+		}
+
+		// Processes any number of samples.  This doesn't allocate, and `output` can be the same as `input`.
+		template<typename InputIterator, typename OutputIterator>
+		void process(InputIterator &&input, OutputIterator &&output, size_t length) {
+			size_t i = 0;
+			while (i < length) {
+				size_t chunk = std::min(std::min(length - i, _blockSize - blockIndex), inputHistory.size() - historyIndex);
+				for (size_t j = 0; j < chunk; ++j) {
+					V value = input[i + j];
+					output[i + j] = outputBlock[blockIndex + j];
+					inputHistory[historyIndex + j] = value;
+				}
+				i += chunk;
+				blockIndex += chunk;
+				historyIndex += chunk;
+				if (historyIndex == inputHistory.size()) historyIndex = 0;
+				if (blockIndex == _blockSize) {
+					processBlock();
+					blockIndex = 0;
+				}
+			}
+		}
 	};
 }
 
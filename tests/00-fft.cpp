@@ -2,16 +2,23 @@
 #include <vector>
 #include <cmath>
 #include <complex>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <sstream>
 
 #include "tests-common.h"
 
 std::vector<int> testSizes() {
 	return {
-		1, 2, 4, 8, 16, 32, 64, 128, 256,
+		0, 1, 2, 4, 8, 16, 32, 64, 128, 256,
 		3, 6, 9, 12, 18, 24,
-		5, 10, 15, 20, 25,
+		5, 10, 15, 20, 25, 125, 480, 960,
 		7, 14, 21, 28, 49,
-		11, 13, 17, 19, 22, 23
+		11, 13, 17, 19, 22, 23,
+		53, 67, 97, 118, 134, 1009
 	};
 }
 
@@ -98,6 +105,521 @@ TEST("Linearity", test_2N_linearity) {
 	}
 }
 
+TEST("Generic iterators", generic_iterators) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	std::vector<int> sizes = testSizes();
+
+	for (int size : sizes) {
+		// Contiguous data goes through the SIMD kernels, other iterators are scalar
+		vector<complex<double>> input(size), output(size);
+		std::deque<complex<double>> dequeInput(size), dequeOutput(size);
+
+		for (int i = 0; i < size; i++) {
+			input[i] = dequeInput[i] = randomComplex<double>();
+		}
+
+		FFT<double> fft(size);
+		fft.fft(input, output);
+		fft.fft(dequeInput.begin(), dequeOutput.begin());
+
+		vector<complex<double>> dequeCopy(dequeOutput.begin(), dequeOutput.end());
+		if (!closeEnough(output, dequeCopy)) {
+			return test.fail("contiguous and generic results differ");
+		}
+	}
+}
+
+TEST("In-place", in_place) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	std::vector<int> sizes = testSizes();
+
+	for (int size : sizes) {
+		vector<complex<double>> input(size), output(size), inPlace(size);
+		std::deque<complex<double>> dequeInPlace(size);
+
+		for (int i = 0; i < size; i++) {
+			input[i] = inPlace[i] = dequeInPlace[i] = randomComplex<double>();
+		}
+
+		FFT<double> fft(size);
+		fft.fft(input, output);
+		fft.fft(inPlace);
+		fft.fft(dequeInPlace.begin(), dequeInPlace.begin());
+
+		vector<complex<double>> dequeCopy(dequeInPlace.begin(), dequeInPlace.end());
+		if (!closeEnough(output, inPlace)) {
+			return test.fail("in-place forward differs");
+		}
+		if (!closeEnough(output, dequeCopy)) {
+			return test.fail("in-place forward differs (generic iterator)");
+		}
+
+		fft.ifft(output, input);
+		fft.ifft(inPlace.data(), inPlace.data());
+		if (!closeEnough(input, inPlace)) {
+			return test.fail("in-place inverse differs");
+		}
+	}
+}
+
+TEST("Unordered", unordered) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	std::vector<int> sizes = testSizes();
+
+	for (int size : sizes) {
+		vector<complex<double>> input(size), spectrum(size), unordered(size), reordered(size), output(size), expected(size);
+		vector<size_t> indices(size);
+
+		for (int i = 0; i < size; i++) {
+			input[i] = randomComplex<double>();
+			expected[i] = input[i]*(double)size;
+		}
+
+		FFT<double> fft(size);
+		fft.fft(input, spectrum);
+		fft.fftUnordered(input, unordered);
+		fft.unorderedIndices(indices);
+		for (int i = 0; i < size; i++) {
+			reordered[i] = unordered[indices[i]];
+		}
+		if (!closeEnough(spectrum, reordered)) {
+			return test.fail("unordered spectrum doesn't match");
+		}
+
+		fft.ifftUnordered(unordered, output);
+		if (!closeEnough(output, expected)) {
+			return test.fail("unordered inverse doesn't match");
+		}
+
+		fft.fftUnordered(input.begin());
+		fft.ifftUnordered(input.begin());
+		if (!closeEnough(input, expected)) {
+			return test.fail("in-place unordered doesn't match");
+		}
+	}
+}
+
+TEST("Batch", batch) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	std::vector<int> sizes = testSizes();
+
+	for (int size : sizes) {
+		FFT<double> fft(size);
+		for (int channels = 1; channels <= 5; ++channels) {
+			// Channels aren't contiguous
+			size_t channelStride = size + 3;
+			vector<complex<double>> input(channels*channelStride), output(channels*channelStride), expected(channels*channelStride);
+			for (auto &v : input) v = randomComplex<double>();
+
+			for (int c = 0; c < channels; ++c) {
+				fft.fft(input.data() + c*channelStride, expected.data() + c*channelStride);
+			}
+			fft.fftBatch(input, output, channels, channelStride);
+			for (int c = 0; c < channels; ++c) {
+				vector<complex<double>> channelOutput(output.begin() + c*channelStride, output.begin() + c*channelStride + size);
+				vector<complex<double>> channelExpected(expected.begin() + c*channelStride, expected.begin() + c*channelStride + size);
+				if (!closeEnough(channelOutput, channelExpected)) {
+					return test.fail("batch forward doesn't match");
+				}
+			}
+
+			for (int c = 0; c < channels; ++c) {
+				fft.ifft(output.data() + c*channelStride, expected.data() + c*channelStride);
+			}
+			fft.ifftBatch(output.data(), output.data(), channels, channelStride);
+			for (int c = 0; c < channels; ++c) {
+				vector<complex<double>> channelOutput(output.begin() + c*channelStride, output.begin() + c*channelStride + size);
+				vector<complex<double>> channelExpected(expected.begin() + c*channelStride, expected.begin() + c*channelStride + size);
+				if (!closeEnough(channelOutput, channelExpected)) {
+					return test.fail("batch inverse (in-place) doesn't match");
+				}
+			}
+		}
+	}
+}
+
+TEST("Threads", threads) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	signalsmith::FFTThreadPool pool(4);
+	// Large enough that the plan is split into independent sub-FFTs
+	for (int size : {1<<15, 1<<17, 3*5*4096, 7*8192, 243*256}) {
+		vector<complex<double>> input(size), expected(size), output(size), inPlace(size), unordered(size), unorderedExpected(size);
+		std::deque<complex<double>> dequeOutput(size);
+		for (auto &v : input) v = randomComplex<double>();
+
+		FFT<double> fft(size);
+		fft.fft(input, expected);
+		fft.fftUnordered(input, unorderedExpected);
+
+		fft.setExecutor(&pool);
+		fft.fft(input, output);
+		if (!closeEnough(output, expected)) return test.fail("threaded forward doesn't match");
+		fft.fft(input.begin(), dequeOutput.begin());
+		vector<complex<double>> dequeCopy(dequeOutput.begin(), dequeOutput.end());
+		if (!closeEnough(dequeCopy, expected)) return test.fail("threaded forward (generic iterator) doesn't match");
+		inPlace = input;
+		fft.fft(inPlace);
+		if (!closeEnough(inPlace, expected)) return test.fail("threaded in-place forward doesn't match");
+		fft.fftUnordered(input, unordered);
+		if (!closeEnough(unordered, unorderedExpected)) return test.fail("threaded unordered forward doesn't match");
+
+		fft.ifft(expected, output);
+		fft.setExecutor(nullptr);
+		fft.ifft(expected, inPlace);
+		if (!closeEnough(output, inPlace)) return test.fail("threaded inverse doesn't match");
+	}
+}
+
+TEST("Threads (back-to-back)", threads_back_to_back) {
+	using signalsmith::FFT;
+	using signalsmith::FFTPlan;
+	using signalsmith::FFTPlanShape;
+	using std::vector;
+	using std::complex;
+
+	signalsmith::FFTThreadPool pool(4);
+	// Lots of tiny `parallelFor()`s in a row, so workers are often still waking up when the next one starts
+	std::atomic<size_t> total{0};
+	std::function<void(size_t)> task = [&](size_t index) {
+		total += index + 1;
+	};
+	for (int repeat = 0; repeat < 20000; ++repeat) {
+		size_t count = 2 + repeat%5;
+		total = 0;
+		pool.parallelFor(count, task);
+		if (total != count*(count + 1)/2) return test.fail("parallelFor() didn't run every task once");
+	}
+
+	// A small plan which is split into sub-FFTs, so each transform has several threaded phases
+	size_t size = 4096;
+	auto plan = std::make_shared<FFTPlan<double>>(size, FFTPlanShape{{4, 4, 4, 4, 4, 4}, 1024});
+	vector<complex<double>> input(size), expected(size), output(size);
+	for (auto &v : input) v = randomComplex<double>();
+	FFT<double> fft(plan);
+	fft.fft(input, expected);
+	fft.setExecutor(&pool);
+	for (int repeat = 0; repeat < 2000; ++repeat) {
+		fft.fft(input, output);
+		if (output != expected) return test.fail("threaded transform doesn't match");
+	}
+}
+
+TEST("Six-step", six_step) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	signalsmith::FFTThreadPool pool(3);
+	// 1, 2 and 6 square blocks for the in-place transpose, and several blocks of columns for the cache
+	for (int size : {1<<20, 1<<21, 3<<19}) {
+		vector<complex<double>> input(size), output(size), inPlace(size), inverse(size);
+		for (auto &v : input) v = randomComplex<double>();
+
+		FFT<double> fft(std::make_shared<signalsmith::FFTPlan<double>>(size, sixStepShape(size)));
+		if (!fft.plan()->shape().sixStep) return test.fail("six-step not used");
+		fft.fft(input, output);
+		// Check some bins against the DFT
+		for (int bin : {0, 1, 5, size/3, size/2 + 7, size - 1}) {
+			complex<double> sum = 0;
+			for (int i = 0; i < size; ++i) {
+				double phase = -2*M_PI*((long long)i*bin%size)/size;
+				sum += input[i]*complex<double>{cos(phase), sin(phase)};
+			}
+			if (std::abs(sum - output[bin]) > 1e-6*std::sqrt(size)) {
+				std::cout << "N = " << size << ", bin " << bin << ": " << output[bin] << " != " << sum << "\n";
+				return test.fail("six-step doesn't match DFT");
+			}
+		}
+
+		inPlace = input;
+		fft.fft(inPlace);
+		if (!closeEnough(inPlace, output)) return test.fail("six-step in-place doesn't match");
+
+		vector<complex<double>> unordered(size);
+		vector<size_t> indices(size);
+		fft.fftUnordered(input, unordered);
+		fft.unorderedIndices(indices);
+		for (int i = 0; i < size; ++i) inPlace[i] = unordered[indices[i]];
+		if (!closeEnough(inPlace, output)) return test.fail("six-step unordered doesn't match");
+		fft.ifftUnordered(unordered);
+		for (auto &v : unordered) v /= size;
+		if (!closeEnough(unordered, input)) return test.fail("six-step unordered inverse doesn't match");
+
+		fft.setExecutor(&pool);
+		inPlace = input;
+		fft.fft(inPlace);
+		if (!closeEnough(inPlace, output)) return test.fail("threaded six-step in-place doesn't match");
+		fft.ifft(output, inverse);
+		for (auto &v : inverse) v /= size;
+		if (!closeEnough(inverse, input)) return test.fail("threaded six-step inverse doesn't match");
+	}
+}
+
+TEST("Shared plan", shared_plan) {
+	using signalsmith::FFT;
+	using signalsmith::FFTPlan;
+	using std::vector;
+	using std::complex;
+
+	// Plain, Rader, Bluestein, and large enough to have split steps
+	for (int size : {480, 97*4, 1009, 1<<15}) {
+		auto plan = std::make_shared<FFTPlan<double>>(size);
+		FFT<double> fft(plan);
+		if (fft.size() != (size_t)size || fft.plan() != plan) return test.fail("FFT should use the given plan");
+
+		const int threadCount = 4;
+		vector<vector<complex<double>>> inputs(threadCount), outputs(threadCount), expected(threadCount);
+		for (int t = 0; t < threadCount; ++t) {
+			inputs[t].resize(size);
+			outputs[t].resize(size);
+			expected[t].resize(size);
+			for (auto &v : inputs[t]) v = randomComplex<double>();
+			FFT<double>(size).fft(inputs[t], expected[t]);
+		}
+
+		// Each thread has its own FFT (working memory), all using the same plan
+		vector<std::thread> threads;
+		vector<vector<complex<double>>> inPlace = inputs;
+		for (int t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&, t]() {
+				FFT<double> threadFft(fft.plan());
+				// The first in-place transform builds the plan's in-place table, so this is also racing the other threads
+				threadFft.fft(inPlace[t]);
+				for (int repeat = 0; repeat < 3; ++repeat) {
+					threadFft.fft(inputs[t], outputs[t]);
+				}
+			});
+		}
+		for (auto &thread : threads) thread.join();
+		for (int t = 0; t < threadCount; ++t) {
+			if (!closeEnough(outputs[t], expected[t])) return test.fail("shared plan doesn't match");
+			if (!closeEnough(inPlace[t], expected[t])) return test.fail("shared plan in-place doesn't match");
+		}
+
+		// Changing the size gets a new plan, and doesn't affect the shared one
+		FFT<double> copy = fft;
+		copy.setSize(size*2);
+		if (copy.plan() == plan || plan->size() != (size_t)size) return test.fail("setSize() should replace the plan");
+		fft.fft(inputs[0], outputs[0]);
+		if (!closeEnough(outputs[0], expected[0])) return test.fail("original FFT changed");
+	}
+}
+
+TEST("Plan shapes and wisdom", plan_shapes) {
+	using signalsmith::FFT;
+	using signalsmith::FFTPlan;
+	using signalsmith::FFTPlanShape;
+	using std::vector;
+	using std::complex;
+
+	auto checkPlan = [&](std::shared_ptr<const FFTPlan<double>> plan) {
+		size_t size = plan->size();
+		vector<complex<double>> input(size), output(size), expected(size);
+		for (auto &v : input) v = randomComplex<double>();
+		FFT<double>(size).fft(input, expected);
+		FFT<double>(plan).fft(input, output);
+		return closeEnough(output, expected);
+	};
+
+	// Any order of factors (with 4, 8 or 16 as a radix) works
+	vector<FFTPlanShape> shapes{
+		{{3, 2, 4, 2}, 65536}, {{2, 2, 2, 2, 3}, 65536}, {{4, 4, 3}, 65536}, {{3, 4, 4}, 65536}, {{2, 3, 2, 2, 2}, 0},
+		{{8, 2, 3}, 65536}, {{3, 8, 2}, 0}, {{16, 3}, 65536}, {{3, 16}, 0}
+	};
+	for (auto &shape : shapes) {
+		auto plan = std::make_shared<FFTPlan<double>>(48, shape);
+		if (plan->shape().radices != shape.radices) return test.fail("shape not used");
+		if (!checkPlan(plan)) return test.fail("shaped plan doesn't match");
+	}
+	for (size_t splitBytes : {size_t(1024), size_t(16384), size_t(-1)}) {
+		for (auto radices : vector<vector<size_t>>{{4, 4, 4, 4, 4, 4, 4, 2}, {2, 4, 4, 4, 4, 4, 4, 4}, {5, 4, 4, 3, 97}, {8, 8, 8, 8, 8, 2}, {4, 16, 16, 16}, {16, 3, 8, 5}}) {
+			size_t size = 1;
+			for (size_t radix : radices) size *= radix;
+			auto plan = std::make_shared<FFTPlan<double>>(size, FFTPlanShape{radices, splitBytes});
+			if (!checkPlan(plan)) return test.fail("split plan doesn't match");
+		}
+	}
+
+	// Split-radix (power-of-2 sizes only)
+	for (size_t size : {1, 2, 4, 8, 16, 32, 64, 1024, 1<<15}) {
+		auto plan = std::make_shared<FFTPlan<double>>(size, FFTPlanShape{FFTPlan<double>(size).shape().radices, 65536, true});
+		if (!plan->shape().splitRadix) return test.fail("split-radix shape not used");
+		if (!checkPlan(plan)) return test.fail("split-radix plan doesn't match");
+
+		vector<complex<double>> input(size), unordered(size), output(size);
+		vector<size_t> indices(size);
+		for (auto &v : input) v = randomComplex<double>();
+		FFT<double> fft(plan);
+		fft.fft(input, output);
+		fft.fftUnordered(input, unordered);
+		fft.unorderedIndices(indices);
+		for (size_t i = 0; i < size; ++i) {
+			if (std::abs(unordered[indices[i]] - output[i]) > 1e-6) return test.fail("split-radix unordered doesn't match");
+		}
+		fft.ifftUnordered(unordered, output);
+		for (size_t i = 0; i < size; ++i) {
+			if (std::abs(output[i] - input[i]*(double)size) > 1e-6*size) return test.fail("split-radix unordered inverse doesn't match");
+		}
+	}
+	if (FFTPlan<double>(48, FFTPlanShape{{3, 4, 4}, 65536, true}).shape().splitRadix) return test.fail("split-radix needs a power of 2");
+
+	// Stockham (radices 2/3/4/5/8/16 only), including odd strides and in-place
+	for (auto radices : vector<vector<size_t>>{{}, {2}, {3}, {4, 4}, {2, 3, 5}, {5, 3, 2}, {8, 3, 16}, {3, 3, 4, 8}, {16, 16, 16, 2}, {4, 4, 4, 4, 4, 4, 4, 4}}) {
+		size_t size = 1;
+		for (size_t radix : radices) size *= radix;
+		auto plan = std::make_shared<FFTPlan<double>>(size, FFTPlanShape{radices, 65536, false, true});
+		if (!plan->shape().stockham) return test.fail("Stockham shape not used");
+		if (!checkPlan(plan)) return test.fail("Stockham plan doesn't match");
+
+		vector<complex<double>> input(size), expected(size), inPlace(size), unordered(size), inverse(size);
+		vector<size_t> indices(size);
+		for (auto &v : input) v = randomComplex<double>();
+		FFT<double>(size).fft(input, expected);
+		FFT<double> fft(plan);
+		inPlace = input;
+		fft.fft(inPlace);
+		if (!closeEnough(inPlace, expected)) return test.fail("Stockham in-place doesn't match");
+		std::deque<complex<double>> inputDeque(input.begin(), input.end()), outputDeque(size);
+		fft.fft(inputDeque.begin(), outputDeque.begin());
+		if (!closeEnough(vector<complex<double>>(outputDeque.begin(), outputDeque.end()), expected)) return test.fail("Stockham non-contiguous doesn't match");
+		fft.fftUnordered(input, unordered);
+		fft.unorderedIndices(indices);
+		for (size_t i = 0; i < size; ++i) {
+			if (std::abs(unordered[indices[i]] - expected[i]) > 1e-6) return test.fail("Stockham unordered doesn't match");
+		}
+		fft.ifft(expected, inverse);
+		fft.ifft(expected);
+		for (size_t i = 0; i < size; ++i) {
+			if (std::abs(inverse[i] - input[i]*(double)size) > 1e-6*size) return test.fail("Stockham inverse doesn't match");
+			if (std::abs(expected[i] - input[i]*(double)size) > 1e-6*size) return test.fail("Stockham in-place inverse doesn't match");
+		}
+
+		vector<complex<float>> floatInput(size), floatOutput(size), floatExpected(size);
+		for (auto &v : floatInput) v = randomComplex<float>();
+		FFT<float>(size).fft(floatInput, floatExpected);
+		FFT<float>(std::make_shared<FFTPlan<float>>(size, FFTPlanShape{radices, 65536, false, true})).fft(floatInput, floatOutput);
+		if (!closeEnough(floatOutput, floatExpected)) return test.fail("float Stockham plan doesn't match");
+	}
+	if (FFTPlan<double>(7*16, FFTPlanShape{{7, 16}, 65536, false, true}).shape().stockham) return test.fail("Stockham doesn't support radix 7");
+
+	// Shapes which don't match the size are ignored
+	for (auto radices : vector<vector<size_t>>{{5, 4}, {2, 2, 2}, {6, 8}, {8, 6}, {4, 4, 3, 1}}) {
+		FFTPlan<double> plan(48, FFTPlanShape{radices, 65536});
+		if (plan.shape().radices != FFTPlan<double>(48).shape().radices) return test.fail("invalid shape should use the default");
+	}
+
+	signalsmith::FFTWisdom wisdom;
+	wisdom.secondsPerShape = 0.0001;
+	for (size_t size : {1, 2, 12, 96, 360, 1024, 97*8, 3<<12}) {
+		auto plan = wisdom.plan<double>(size);
+		if (!checkPlan(plan)) return test.fail("measured plan doesn't match");
+	}
+	auto floatPlan = wisdom.plan<float>(480);
+	if (wisdom.count() != 9) return test.fail("wisdom should have 9 entries");
+
+	std::stringstream stream;
+	wisdom.save(stream);
+	signalsmith::FFTWisdom loaded;
+	loaded.measure = false;
+	if (!loaded.load(stream) || loaded.count() != wisdom.count()) return test.fail("failed to load wisdom");
+	for (size_t size : {12, 96, 360, 1024, 97*8, 3<<12}) {
+		if (loaded.plan<double>(size)->shape().radices != wisdom.plan<double>(size)->shape().radices) return test.fail("loaded shape doesn't match");
+	}
+	if (loaded.plan<float>(480)->shape().radices != floatPlan->shape().radices) return test.fail("loaded float shape doesn't match");
+	if (loaded.count() != wisdom.count()) return test.fail("shouldn't measure unknown sizes");
+
+	// Split-radix and Stockham are saved, and the older formats (without them) still load
+	std::stringstream splitStream("signalsmith-fft-wisdom 2\n8 64 65536 1 4 4 4\n4 64 65536 0 4 4 4\n"), oldStream("signalsmith-fft-wisdom 1\n8 96 65536 3 4 4 2\n");
+	std::stringstream stockhamStream("signalsmith-fft-wisdom 3\n8 60 65536 0 1 3 4 5\n");
+	// Version 3 always used six-step for 16MB or more, so those lines are skipped
+	std::stringstream sixStepStream("signalsmith-fft-wisdom 4\n8 4096 65536 0 0 1 4 4 4 4 4 4\n"), oldSixStepStream("signalsmith-fft-wisdom 3\n8 1048576 65536 0 0 4 4 4 4 4 4 4 4 4 4\n");
+	signalsmith::FFTWisdom splitWisdom;
+	splitWisdom.measure = false;
+	if (!splitWisdom.load(splitStream) || !splitWisdom.load(oldStream) || !splitWisdom.load(stockhamStream) || splitWisdom.count() != 4) return test.fail("failed to load wisdom");
+	if (!splitWisdom.load(sixStepStream) || !splitWisdom.load(oldSixStepStream) || splitWisdom.count() != 5) return test.fail("failed to load six-step wisdom");
+	if (!splitWisdom.plan<double>(4096)->shape().sixStep) return test.fail("six-step not loaded");
+	if (!splitWisdom.plan<double>(64)->shape().splitRadix || splitWisdom.plan<float>(64)->shape().splitRadix) return test.fail("split-radix not loaded");
+	if (splitWisdom.plan<double>(96)->shape().radices != vector<size_t>{3, 4, 4, 2}) return test.fail("old wisdom not loaded");
+	if (!splitWisdom.plan<double>(60)->shape().stockham) return test.fail("Stockham not loaded");
+	std::stringstream splitSaved;
+	splitWisdom.save(splitSaved);
+	signalsmith::FFTWisdom splitReloaded;
+	if (!splitReloaded.load(splitSaved) || !splitReloaded.plan<double>(64)->shape().splitRadix) return test.fail("split-radix not saved");
+	if (!splitReloaded.plan<double>(60)->shape().stockham) return test.fail("Stockham not saved");
+	if (!splitReloaded.plan<double>(4096)->shape().sixStep) return test.fail("six-step not saved");
+
+	for (std::string invalid : {"", "something else\n", "signalsmith-fft-wisdom 1\n8 12 65536 4 2\n", "signalsmith-fft-wisdom 1\n8 12 65536 4 x\n", "signalsmith-fft-wisdom 2\n8 12 65536 x 4 3\n"}) {
+		std::stringstream invalidStream(invalid);
+		signalsmith::FFTWisdom invalidWisdom;
+		if (invalidWisdom.load(invalidStream) || invalidWisdom.count()) return test.fail("invalid wisdom shouldn't load");
+	}
+}
+
+template<typename V, size_t size>
+bool fixedMatches() {
+	using signalsmith::FFT;
+	using signalsmith::FixedFFT;
+	using std::vector;
+	using std::complex;
+
+	vector<complex<V>> input(size), output(size), expected(size);
+	for (auto &v : input) v = randomComplex<V>();
+
+	// Same steps and butterflies, so the results should be identical
+	FFT<V> fft(size);
+	fft.fft(input, expected);
+	FixedFFT<V, size>::fft(input, output);
+	if (output != expected) return false;
+
+	vector<complex<V>> inPlace = input;
+	FixedFFT<V, size> fixedFft;
+	fixedFft.fft(inPlace);
+	if (inPlace != expected) return false;
+
+	fft.ifft(input, expected);
+	FixedFFT<V, size>::ifft(input.data(), output.data());
+	if (output != expected) return false;
+	FixedFFT<V, size>::ifft(input);
+	if (input != expected) return false;
+
+	// Non-contiguous data uses the scalar butterflies
+	std::deque<complex<V>> outputDeque(size);
+	FixedFFT<V, size>::fft(output, outputDeque.begin());
+	fft.fft(output, expected);
+	output.assign(outputDeque.begin(), outputDeque.end());
+	return closeEnough(output, expected) && FixedFFT<V, size>::size() == size;
+}
+
+TEST("Fixed-size FFT", fixed_fft) {
+	if (!fixedMatches<double, 1>()) return test.fail("N = 1");
+	if (!fixedMatches<double, 2>()) return test.fail("N = 2");
+	if (!fixedMatches<double, 8>()) return test.fail("N = 8");
+	if (!fixedMatches<double, 16>()) return test.fail("N = 16");
+	if (!fixedMatches<double, 32>()) return test.fail("N = 32");
+	if (!fixedMatches<double, 64>()) return test.fail("N = 64");
+	if (!fixedMatches<double, 15>()) return test.fail("N = 15");
+	if (!fixedMatches<double, 60>()) return test.fail("N = 60");
+	if (!fixedMatches<double, 480>()) return test.fail("N = 480");
+	if (!fixedMatches<float, 8>()) return test.fail("float N = 8");
+	if (!fixedMatches<float, 32>()) return test.fail("float N = 32");
+	if (!fixedMatches<float, 96>()) return test.fail("float N = 96");
+}
+
 template<int fixedHarmonics=-1>
 void inverseTest(Test test) {
 	using signalsmith::FFT;
@@ -2,6 +2,7 @@
 #include <vector>
 #include <cmath>
 #include <complex>
+#include <deque>
 
 #include "tests-common.h"
 
@@ -95,6 +96,113 @@ void test_real(Test &test) {
 	}
 }
 
+template<bool modified=false>
+void test_in_place(Test &test) {
+	using signalsmith::RealFFT;
+	using signalsmith::ModifiedRealFFT;
+	using std::vector;
+	using std::complex;
+
+	for (int size = 2; size < 100; size += 2) {
+		vector<double> input(size), output(size);
+		vector<complex<double>> spectrum(size/2);
+		// The same memory, used for both the real signal and the complex spectrum
+		vector<complex<double>> shared(size/2);
+		double *sharedReal = (double *)shared.data();
+
+		typename std::conditional<modified, ModifiedRealFFT<double>, RealFFT<double>>::type realFft(size);
+
+		for (int i = 0; i < size; ++i) {
+			input[i] = sharedReal[i] = rand()/(double)RAND_MAX - 0.5;
+		}
+
+		realFft.fft(input, spectrum);
+		realFft.fft(sharedReal, shared.data());
+		for (int i = 0; i < size/2; ++i) {
+			if (abs(spectrum[i] - shared[i]) > size*1e-6) return FAIL_VALUE_PAIR(spectrum[i], shared[i]);
+		}
+
+		realFft.ifft(spectrum, output);
+		realFft.ifft(shared.data(), sharedReal);
+		for (int i = 0; i < size; ++i) {
+			if (abs(output[i] - sharedReal[i]) > size*1e-6) return FAIL_VALUE_PAIR(output[i], sharedReal[i]);
+		}
+	}
+}
+
+template<bool modified=false>
+void test_unordered(Test &test) {
+	using signalsmith::FFT;
+	using signalsmith::RealFFT;
+	using signalsmith::ModifiedRealFFT;
+	using std::vector;
+	using std::complex;
+
+	for (int size = 2; size < 100; size += 2) {
+		vector<double> input(size), output(size);
+		vector<complex<double>> spectrum(size/2), unordered(size/2);
+		vector<size_t> indices(size/2);
+
+		typename std::conditional<modified, ModifiedRealFFT<double>, RealFFT<double>>::type realFft(size);
+		FFT<double>(size/2).unorderedIndices(indices);
+
+		for (int i = 0; i < size; ++i) {
+			input[i] = rand()/(double)RAND_MAX - 0.5;
+		}
+
+		realFft.fft(input, spectrum);
+		realFft.fftUnordered(input, unordered);
+		for (int i = 0; i < size/2; ++i) {
+			complex<double> diff = spectrum[i] - unordered[indices[i]];
+			if (abs(diff) > size*1e-6) {
+				LOG_VALUE(size);
+				LOG_VALUE(i);
+				return FAIL_VALUE_PAIR(spectrum[i], unordered[indices[i]]);
+			}
+		}
+
+		realFft.ifftUnordered(unordered, output);
+		for (int i = 0; i < size; ++i) {
+			if (abs(output[i] - input[i]*size) > size*1e-6) return FAIL_VALUE_PAIR(output[i], input[i]*size);
+		}
+	}
+}
+
+// Containers which aren't contiguous can't hold the complex FFT's data, so these use a separate buffer
+template<bool modified=false>
+void test_non_contiguous(Test &test) {
+	using signalsmith::RealFFT;
+	using signalsmith::ModifiedRealFFT;
+	using std::vector;
+	using std::deque;
+	using std::complex;
+
+	for (int size = 2; size < 100; size += 2) {
+		vector<double> input(size), output(size);
+		vector<complex<double>> spectrum(size/2);
+		deque<double> dequeInput(size), dequeOutput(size);
+		deque<complex<double>> dequeSpectrum(size/2);
+
+		typename std::conditional<modified, ModifiedRealFFT<double>, RealFFT<double>>::type realFft(size);
+
+		for (int i = 0; i < size; ++i) {
+			input[i] = dequeInput[i] = rand()/(double)RAND_MAX - 0.5;
+		}
+
+		realFft.fft(input, spectrum);
+		realFft.fft(dequeInput, dequeSpectrum);
+		for (int i = 0; i < size/2; ++i) {
+			if (abs(spectrum[i] - dequeSpectrum[i]) > size*1e-6) return FAIL_VALUE_PAIR(spectrum[i], dequeSpectrum[i]);
+		}
+
+		realFft.ifft(spectrum, output);
+		realFft.ifft(dequeSpectrum, dequeOutput);
+		for (int i = 0; i < size; ++i) {
+			if (abs(output[i] - dequeOutput[i]) > size*1e-6) return FAIL_VALUE_PAIR(output[i], dequeOutput[i]);
+		}
+	}
+}
+
 TEST("Random real", random_real) {
 	test_real<false>(test);
 }
@@ -102,3 +210,34 @@ TEST("Random real", random_real) {
 TEST("Modified real", random_modified_real) {
 	test_real<true>(test);
 }
+
+TEST("In-place real", real_in_place) {
+	test_in_place<false>(test);
+	test_in_place<true>(test);
+}
+
+TEST("Non-contiguous real", real_non_contiguous) {
+	test_non_contiguous<false>(test);
+	test_non_contiguous<true>(test);
+}
+
+TEST("Unordered real", real_unordered) {
+	test_unordered<false>(test);
+	test_unordered<true>(test);
+}
+
+TEST("Real sizes", real_sizes) {
+	using signalsmith::FFT;
+	using signalsmith::RealFFT;
+
+	for (size_t i = 2; i < 1000; ++i) {
+		size_t above = RealFFT<double>::sizeMinimum(i);
+		size_t below = RealFFT<double>::sizeMaximum(i);
+
+		if (above < i) return test.fail("above < i");
+		if (below > i) return test.fail("below > i");
+		if (above%2 || below%2) return test.fail("real sizes must be even");
+		if (FFT<double>::sizeMinimum(above/2) != above/2) return test.fail("non-fast above");
+		if (FFT<double>::sizeMinimum(below/2) != below/2) return test.fail("non-fast below");
+	}
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "tests-common.h"
+
+template<typename V>
+std::vector<V> directConvolution(const std::vector<V> &signal, const std::vector<V> &filter) {
+	std::vector<V> result(signal.size());
+	for (size_t i = 0; i < signal.size(); ++i) {
+		V sum = 0;
+		for (size_t j = 0; j < filter.size() && j <= i; ++j) {
+			sum += filter[j]*signal[i - j];
+		}
+		result[i] = sum;
+	}
+	return result;
+}
+
+void testConvolver(Test &test, size_t filterLength, size_t blockSize) {
+	using signalsmith::Convolver;
+
+	std::vector<double> filter(filterLength), input(2000);
+	for (auto &v : filter) v = rand()/(double)RAND_MAX - 0.5;
+	for (auto &v : input) v = rand()/(double)RAND_MAX - 0.5;
+	std::vector<double> expected = directConvolution(input, filter);
+
+	Convolver<double> convolver(filter, filterLength, blockSize);
+	if (blockSize > 0 && convolver.latency() != blockSize) return test.fail("latency should match block size");
+	if (convolver.fftSize() < convolver.latency() + filterLength - 1) return test.fail("FFT is too small");
+
+	// Process in irregular chunks
+	std::vector<double> output(input.size());
+	size_t index = 0;
+	while (index < input.size()) {
+		size_t chunk = std::min<size_t>(rand()%50, input.size() - index);
+		convolver.process(input.data() + index, output.data() + index, chunk);
+		index += chunk;
+	}
+
+	size_t latency = convolver.latency();
+	for (size_t i = 0; i < input.size(); ++i) {
+		double expectedValue = (i < latency) ? 0 : expected[i - latency];
+		if (std::abs(output[i] - expectedValue) > 1e-6) {
+			std::cout << "filter length " << filterLength << ", block size " << blockSize << ", i = " << i << "\n";
+			std::cout << output[i] << " != " << expectedValue << "\n";
+			return test.fail("output doesn't match direct convolution");
+		}
+	}
+}
+
+TEST("Convolver", convolver) {
+	for (size_t filterLength : {1, 2, 7, 32, 100, 257}) {
+		testConvolver(test, filterLength, 0);
+		if (!test.success) return;
+		for (size_t blockSize : {1, 16, 33, 128}) {
+			testConvolver(test, filterLength, blockSize);
+			if (!test.success) return;
+		}
+	}
+}
+
+TEST("Convolver in-place and reset", convolver_in_place) {
+	using signalsmith::Convolver;
+
+	std::vector<double> filter(50), input(500);
+	for (auto &v : filter) v = rand()/(double)RAND_MAX - 0.5;
+	for (auto &v : input) v = rand()/(double)RAND_MAX - 0.5;
+
+	Convolver<double> convolver(filter, filter.size());
+	std::vector<double> output(input.size());
+	convolver.process(input, output, input.size());
+
+	convolver.reset();
+	std::vector<double> inPlace = input;
+	convolver.process(inPlace, inPlace, inPlace.size());
+
+	for (size_t i = 0; i < input.size(); ++i) {
+		if (output[i] != inPlace[i]) return test.fail("in-place result differs after reset()");
+	}
+}
+
+void testPartitioned(Test &test, size_t filterLength, size_t blockSize, size_t maxPartitionSize) {
+	using signalsmith::PartitionedConvolver;
+
+	std::vector<double> filter(filterLength), input(6000);
+	for (auto &v : filter) v = rand()/(double)RAND_MAX - 0.5;
+	for (auto &v : input) v = rand()/(double)RAND_MAX - 0.5;
+	std::vector<double> expected = directConvolution(input, filter);
+
+	PartitionedConvolver<double> convolver(filter, filterLength, blockSize, maxPartitionSize);
+	if (convolver.latency() != blockSize) return test.fail("latency should match block size");
+
+	std::vector<double> output(input.size());
+	size_t index = 0;
+	while (index < input.size()) {
+		size_t chunk = std::min<size_t>(rand()%100, input.size() - index);
+		convolver.process(input.data() + index, output.data() + index, chunk);
+		index += chunk;
+	}
+
+	for (size_t i = 0; i < input.size(); ++i) {
+		double expectedValue = (i < blockSize) ? 0 : expected[i - blockSize];
+		if (std::abs(output[i] - expectedValue) > 1e-6) {
+			std::cout << "filter length " << filterLength << ", block size " << blockSize << ", max partition " << maxPartitionSize << ", i = " << i << "\n";
+			std::cout << output[i] << " != " << expectedValue << "\n";
+			return test.fail("output doesn't match direct convolution");
+		}
+	}
+}
+
+TEST("Partitioned convolver", partitioned_convolver) {
+	for (size_t filterLength : {1, 10, 64, 300, 2500}) {
+		for (size_t blockSize : {1, 16, 24, 64}) {
+			testPartitioned(test, filterLength, blockSize, 16384);
+			if (!test.success) return;
+			testPartitioned(test, filterLength, blockSize, blockSize*4);
+			if (!test.success) return;
+		}
+	}
+}
+
+TEST("Partitioned convolver spreads its work", partitioned_work) {
+	using signalsmith::PartitionedConvolver;
+
+	size_t blockSize = 32;
+	std::vector<double> filter(60000);
+	for (auto &v : filter) v = rand()/(double)RAND_MAX - 0.5;
+	PartitionedConvolver<double> convolver(filter, filter.size(), blockSize);
+
+	// The largest segment has a cycle of 16384/32 blocks, so this includes several of them (after the first, which starts part-way through)
+	size_t warmup = 512, blocks = 4096;
+	std::vector<double> block(blockSize);
+	size_t maxWork = 0, totalWork = 0;
+	for (size_t b = 0; b < blocks; ++b) {
+		for (auto &v : block) v = rand()/(double)RAND_MAX - 0.5;
+		convolver.process(block, block, blockSize);
+		if (b < warmup) continue;
+		maxWork = std::max(maxWork, convolver.blockWork());
+		totalWork += convolver.blockWork();
+	}
+	double meanWork = totalWork/double(blocks - warmup);
+	// Running the largest segment's whole FFT in one block would be over 25 times the average
+	if (maxWork > meanWork*1.5) {
+		std::cout << "max " << maxWork << ", mean " << meanWork << "\n";
+		return test.fail("work per block should be even");
+	}
+}
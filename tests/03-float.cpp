@@ -0,0 +1,143 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <deque>
+
+#include "tests-common.h"
+
+// RMS error relative to the RMS of the (double-precision) reference
+template<typename T>
+double relativeError(const T &result, const std::vector<std::complex<double>> &expected) {
+	double totalError = 0, totalEnergy = 0;
+	for (size_t i = 0; i < expected.size(); ++i) {
+		std::complex<double> value = result[i];
+		totalError += std::norm(value - expected[i]);
+		totalEnergy += std::norm(expected[i]);
+	}
+	return totalEnergy ? std::sqrt(totalError/totalEnergy) : 0;
+}
+
+// Single-precision rounding is ~6e-8, and the error grows slowly with the number of stages
+double floatTolerance(size_t size) {
+	return 4e-8*(2 + std::log2(size + 1));
+}
+
+std::vector<int> floatSizes() {
+	return {
+		1, 2, 3, 4, 5, 6, 7, 8, 9, 12, 15, 16, 17, 25, 28,
+		32, 36, 49, 64, 97, 125, 256, 480, 960, 1009, 1024,
+		3*5*7*16, 4096, 65536, 3<<14, 1<<17
+	};
+}
+
+TEST("Float accuracy", float_accuracy) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	for (int size : floatSizes()) {
+		vector<complex<float>> input(size), output(size), inverse(size);
+		vector<complex<double>> inputDouble(size), expected(size);
+		for (int i = 0; i < size; ++i) {
+			input[i] = randomComplex<float>();
+			inputDouble[i] = input[i];
+		}
+
+		FFT<double> fftDouble(size);
+		fftDouble.fft(inputDouble, expected);
+
+		FFT<float> fft(size);
+		fft.fft(input, output);
+		double error = relativeError(output, expected);
+		if (error > floatTolerance(size)) {
+			std::cout << "N = " << size << ", error " << error << "\n";
+			return test.fail("float forward error too large");
+		}
+
+		fft.ifft(output, inverse);
+		for (auto &v : inverse) v /= size;
+		error = relativeError(inverse, inputDouble);
+		if (error > 2*floatTolerance(size)) {
+			std::cout << "N = " << size << ", error " << error << "\n";
+			return test.fail("float inverse error too large");
+		}
+	}
+}
+
+TEST("Float SIMD paths", float_simd) {
+	using signalsmith::FFT;
+	using std::vector;
+	using std::complex;
+
+	for (int size : floatSizes()) {
+		vector<complex<float>> input(size), output(size);
+		vector<complex<double>> expected(size);
+		for (auto &v : input) v = randomComplex<float>();
+
+		FFT<float> fft(size);
+		fft.fft(input, output);
+		for (int i = 0; i < size; ++i) expected[i] = output[i];
+		double tolerance = floatTolerance(size);
+
+		// A std::deque isn't contiguous, so it uses the scalar butterflies
+		std::deque<complex<float>> inputDeque(input.begin(), input.end()), outputDeque(size);
+		fft.fft(inputDeque.begin(), outputDeque.begin());
+		if (relativeError(outputDeque, expected) > tolerance) return test.fail("float scalar/SIMD mismatch");
+
+		vector<complex<float>> inPlace = input;
+		fft.fft(inPlace);
+		if (relativeError(inPlace, expected) > tolerance) return test.fail("float in-place mismatch");
+
+		vector<complex<float>> unordered(size);
+		vector<size_t> indices(size);
+		fft.fftUnordered(input, unordered);
+		fft.unorderedIndices(indices);
+		for (int i = 0; i < size; ++i) inPlace[i] = unordered[indices[i]];
+		if (relativeError(inPlace, expected) > tolerance) return test.fail("float unordered mismatch");
+
+		// Enough channels for a full group of SIMD lanes, plus some left over
+		if (size > 1024) continue;
+		const int channels = 11;
+		size_t channelStride = size + 1;
+		vector<complex<float>> batchInput(channels*channelStride), batchOutput(channels*channelStride);
+		for (auto &v : batchInput) v = randomComplex<float>();
+		fft.fftBatch(batchInput, batchOutput, channels, channelStride);
+		for (int c = 0; c < channels; ++c) {
+			fft.fft(batchInput.data() + c*channelStride, output.data());
+			for (int i = 0; i < size; ++i) expected[i] = output[i];
+			if (relativeError(batchOutput.data() + c*channelStride, expected) > tolerance) return test.fail("float batch mismatch");
+		}
+	}
+}
+
+TEST("Float real", float_real) {
+	using signalsmith::RealFFT;
+	using std::vector;
+	using std::complex;
+
+	for (int size : {2, 6, 16, 30, 256, 1000, 4096}) {
+		vector<float> input(size), inverse(size);
+		vector<double> inputDouble(size);
+		for (int i = 0; i < size; ++i) {
+			input[i] = rand()/(float)RAND_MAX - 0.5f;
+			inputDouble[i] = input[i];
+		}
+		vector<complex<float>> spectrum(size/2);
+		vector<complex<double>> expected(size/2);
+
+		RealFFT<double> realDouble(size);
+		realDouble.fft(inputDouble, expected);
+		RealFFT<float> realFft(size);
+		realFft.fft(input, spectrum);
+		if (relativeError(spectrum, expected) > floatTolerance(size)) return test.fail("float real forward error too large");
+
+		realFft.ifft(spectrum, inverse);
+		vector<complex<double>> inverseComplex(size), inputComplex(size);
+		for (int i = 0; i < size; ++i) {
+			inverseComplex[i] = inverse[i]/size;
+			inputComplex[i] = inputDouble[i];
+		}
+		if (relativeError(inverseComplex, inputComplex) > 2*floatTolerance(size)) return test.fail("float real inverse error too large");
+	}
+}
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <deque>
+
+#include "tests-common.h"
+
+// A bump allocator over a fixed block (like a real-time pool), which counts outstanding allocations
+struct TestPool {
+	std::vector<char> memory;
+	size_t used = 0;
+	int allocations = 0, outstanding = 0;
+
+	TestPool(size_t bytes) : memory(bytes) {}
+
+	void * allocate(size_t bytes) {
+		size_t start = (used + 63)&~size_t(63);
+		if (start + bytes > memory.size()) throw std::bad_alloc();
+		used = start + bytes;
+		++allocations;
+		++outstanding;
+		return memory.data() + start;
+	}
+	void deallocate(void *) {
+		--outstanding;
+	}
+};
+
+// Stateful, and not default-constructible
+template<typename T>
+struct TestPoolAllocator {
+	using value_type = T;
+	TestPool *pool;
+
+	TestPoolAllocator(TestPool *pool) : pool(pool) {}
+	template<typename U>
+	TestPoolAllocator(const TestPoolAllocator<U> &other) : pool(other.pool) {}
+
+	T * allocate(size_t n) {
+		return (T *)pool->allocate(n*sizeof(T));
+	}
+	void deallocate(T *pointer, size_t) {
+		pool->deallocate(pointer);
+	}
+	template<typename U>
+	bool operator==(const TestPoolAllocator<U> &other) const {
+		return pool == other.pool;
+	}
+	template<typename U>
+	bool operator!=(const TestPoolAllocator<U> &other) const {
+		return pool != other.pool;
+	}
+};
+
+TEST("Default allocator is aligned", default_allocator) {
+	signalsmith::FFTAllocator<std::complex<double>> allocator;
+	for (size_t size : {1, 2, 3, 7, 64, 1000}) {
+		std::complex<double> *pointer = allocator.allocate(size);
+		if ((uintptr_t)pointer%64) return test.fail("not aligned to 64 bytes");
+		for (size_t i = 0; i < size; ++i) pointer[i] = {1, 2};
+		allocator.deallocate(pointer, size);
+	}
+
+	signalsmith::FFTAllocator<char, 4096> pageAllocator;
+	char *page = pageAllocator.allocate(10);
+	if ((uintptr_t)page%4096) return test.fail("not aligned to 4096 bytes");
+	pageAllocator.deallocate(page, 10);
+}
+
+TEST("Custom allocator", custom_allocator) {
+	using std::vector;
+	using std::complex;
+	using Allocator = TestPoolAllocator<complex<double>>;
+
+	TestPool pool(1<<26);
+	{
+		Allocator allocator(&pool);
+		// Plain, Rader, Bluestein, and six-step
+		for (int size : {480, 97*4, 1009, 1<<20}) {
+			vector<complex<double>> input(size), output(size), expected(size);
+			for (auto &v : input) v = randomComplex<double>();
+			signalsmith::FFT<double>(size).fft(input, expected);
+
+			int allocationsBefore = pool.allocations;
+			using Plan = signalsmith::FFTPlan<double, Allocator>;
+			auto plan = (size == 1<<20) ? std::allocate_shared<Plan>(allocator, size, sixStepShape(size), allocator) : std::allocate_shared<Plan>(allocator, size, allocator);
+			signalsmith::FFT<double, Allocator> fft(plan, allocator);
+			if (pool.allocations == allocationsBefore) return test.fail("allocator not used");
+			fft.fft(input, output);
+			if (!closeEnough(output, expected)) return test.fail("FFT with allocator doesn't match");
+
+			// Copies (and other FFTs sharing the plan) use the same allocator
+			auto copy = fft;
+			signalsmith::FFT<double, Allocator> shared(fft.plan(), allocator);
+			copy.fft(input, output);
+			if (!closeEnough(output, expected)) return test.fail("copied FFT doesn't match");
+			shared.fft(input, output);
+			if (!closeEnough(output, expected)) return test.fail("shared FFT doesn't match");
+		}
+
+		signalsmith::RealFFT<double, 0, Allocator> realFft(256, allocator);
+		signalsmith::ModifiedRealFFT<double, Allocator> modifiedFft(256, allocator);
+		vector<double> realInput(256), realOutput(256);
+		vector<complex<double>> spectrum(128);
+		for (auto &v : realInput) v = rand()/(double)RAND_MAX - 0.5;
+		realFft.fft(realInput, spectrum);
+		realFft.ifft(spectrum, realOutput);
+		for (size_t i = 0; i < 256; ++i) {
+			if (std::abs(realOutput[i] - realInput[i]*256) > 1e-10) return test.fail("RealFFT with allocator doesn't match");
+		}
+		modifiedFft.fft(realInput, spectrum);
+	}
+	if (pool.outstanding) return test.fail("allocations not freed");
+}
+
+TEST("Reserved sizes don't allocate", reserved_sizes) {
+	using std::vector;
+	using std::complex;
+	using Allocator = TestPoolAllocator<complex<double>>;
+
+	TestPool pool(1<<24);
+	{
+		Allocator allocator(&pool);
+		// Plain, Rader and Bluestein
+		vector<int> sizes = {256, 480, 97*4, 1009};
+		signalsmith::FFT<double, Allocator> fft(64, allocator);
+		for (int size : sizes) fft.reserve(size);
+		signalsmith::RealFFT<double, 0, Allocator> realFft(64, allocator);
+		for (int size : {64, 256, 1024}) realFft.reserve(size);
+
+		vector<complex<double>> input(1024), output(1024);
+		vector<double> realInput(1024), realOutput(1024);
+		for (auto &v : input) v = randomComplex<double>();
+		for (auto &v : realInput) v = rand()/(double)RAND_MAX - 0.5;
+
+		int allocationsBefore = pool.allocations;
+		for (int repeat = 0; repeat < 2; ++repeat) {
+			for (int size : sizes) {
+				fft.setSize(size);
+				fft.fft(input, output);
+				fft.ifft(output, output);
+				for (int i = 0; i < size; ++i) {
+					if (std::abs(output[i] - input[i]*(double)size) > 1e-8) return test.fail("reserved FFT doesn't match");
+				}
+			}
+			for (int size : {256, 1024, 64}) {
+				realFft.setSize(size);
+				realFft.fft(realInput, output);
+				realFft.ifft(output, realOutput);
+				for (int i = 0; i < size; ++i) {
+					if (std::abs(realOutput[i] - realInput[i]*size) > 1e-8) return test.fail("reserved RealFFT doesn't match");
+				}
+				realFft.fftUnordered(realInput, output);
+				realFft.ifftUnordered(output, realOutput);
+				for (int i = 0; i < size; ++i) {
+					if (std::abs(realOutput[i] - realInput[i]*size) > 1e-8) return test.fail("reserved unordered RealFFT doesn't match");
+				}
+			}
+		}
+		if (pool.allocations != allocationsBefore) return test.fail("switching between reserved sizes allocated");
+
+		// Unreserved sizes still work, and reserved ones are kept
+		fft.setSize(100);
+		fft.setSize(480);
+		allocationsBefore = pool.allocations;
+		fft.setSize(1009);
+		if (pool.allocations != allocationsBefore) return test.fail("reserved size was dropped");
+	}
+	if (pool.outstanding) return test.fail("allocations not freed");
+}
+
+TEST("Computing doesn't allocate", computing) {
+	using std::vector;
+	using std::complex;
+	using Allocator = TestPoolAllocator<complex<double>>;
+
+	TestPool pool(1<<27);
+	{
+		Allocator allocator(&pool);
+		// Threaded six-step, with the executor set after the size
+		int size = 1<<20;
+		vector<complex<double>> input(size), output(size), expected(size);
+		for (auto &v : input) v = randomComplex<double>();
+		signalsmith::FFT<double>(size).fft(input, expected);
+
+		signalsmith::FFTThreadPool threadPool(4);
+		signalsmith::FFT<double, Allocator> fft(std::allocate_shared<signalsmith::FFTPlan<double, Allocator>>(allocator, size, sixStepShape(size), allocator), allocator);
+		fft.setExecutor(&threadPool);
+		int allocationsBefore = pool.allocations;
+		fft.fft(input, output);
+		if (pool.allocations != allocationsBefore) return test.fail("threaded six-step allocated");
+		if (!closeEnough(output, expected)) return test.fail("threaded six-step doesn't match");
+
+		// RealFFT with iterators which can't hold the complex FFT directly
+		signalsmith::RealFFT<double, 0, Allocator> realFft(256, allocator);
+		std::deque<double> realInput(256), realOutput(256);
+		std::deque<complex<double>> spectrum(128);
+		for (auto &v : realInput) v = rand()/(double)RAND_MAX - 0.5;
+		allocationsBefore = pool.allocations;
+		realFft.fft(realInput.begin(), spectrum.begin());
+		realFft.ifft(spectrum.begin(), realOutput.begin());
+		if (pool.allocations != allocationsBefore) return test.fail("RealFFT allocated");
+		for (size_t i = 0; i < 256; ++i) {
+			if (std::abs(realOutput[i] - realInput[i]*256) > 1e-10) return test.fail("RealFFT with deques doesn't match");
+		}
+	}
+	if (pool.outstanding) return test.fail("allocations not freed");
+}
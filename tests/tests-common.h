@@ -40,3 +40,13 @@ static void printArray(std::vector<T> array, bool newline=true) {
 	}
 	if (newline) std::cout << std::endl;
 }
+
+// Six-step is only the default for huge sizes, but the plan shape can ask for it (the radices are only used if it's not possible)
+inline signalsmith::FFTPlanShape sixStepShape(size_t size) {
+	signalsmith::FFTPlanShape shape;
+	for (size_t factor : {2, 3, 5}) {
+		for (; size%factor == 0; size /= factor) shape.radices.push_back(factor);
+	}
+	shape.sixStep = true;
+	return shape;
+}